@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - ALLOCATION COUNTER
+// DESCRIPTION: Replaces the global operator new and delete, every form of them, with malloc and free plus a
+// count for heapAllocations(). Built into the programs that report allocations rather than into the core
+// library, so nothing gets a different allocator by accident.
+// The runners and benches are built with ASTEROIDS_COUNT_ALLOCATIONS and always count. The game only counts
+// when its profiler is compiled in (see profile.h), a release game is left with the normal allocator.
+///////////////////////////////////////////////////
+
+#include "profile.h"
+
+#if ASTEROIDS_PROFILING || defined(ASTEROIDS_COUNT_ALLOCATIONS)
+
+#include <cstdlib>
+#include <new>
+
+void *operator new(size_t n) {
+    countHeapAllocation();
+    void *p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t n) {
+    return operator new(n);
+}
+
+void *operator new(size_t n, const std::nothrow_t &) noexcept {
+    countHeapAllocation();
+    return malloc(n ? n : 1);
+}
+
+void *operator new[](size_t n, const std::nothrow_t &) noexcept {
+    return operator new(n, std::nothrow);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    free(p);
+}
+
+#endif
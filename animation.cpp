@@ -0,0 +1,12 @@
+#include "animation.h"
+
+const AnimClip CLIPS[ANIM_COUNT] = {
+        {"images/explosions/type_C.png", 0, 0, 256, 256, 48, 0.5}, // ANIM_EXPLOSION
+        {"images/rock.png", 0, 0, 64, 64, 16, 0.2}, // ANIM_ROCK
+        {"images/rock_small.png", 0, 0, 64, 64, 16, 0.2}, // ANIM_ROCK_SMALL
+        {"images/fire_red.png", 0, 0, 32, 64, 16, 0.8}, // ANIM_BULLET
+        {"images/spaceship.png", 40, 0, 40, 40, 1, 0}, // ANIM_PLAYER
+        {"images/spaceship.png", 40, 40, 40, 40, 1, 0}, // ANIM_PLAYER_GO
+        {"images/explosions/type_B.png", 0, 0, 192, 192, 64, 0.5}, // ANIM_EXPLOSION_SHIP
+        {"images/UFO.png", 0, 0, 70, 70, 1, 0.1} // ANIM_UFO
+};
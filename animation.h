@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - ANIMATION CLIPS
+// DESCRIPTION: Every animation in the game is described once, here: which picture it comes from, where its
+// frames sit, how many there are and how fast they play. Entities only carry the clip's id and their own
+// position in it, so spawning an animated entity copies three numbers.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_ANIMATION_H
+#define ASTEROIDS_ANIMATION_H
+
+// which picture/animation an entity is showing
+enum AnimId {
+    ANIM_EXPLOSION,
+    ANIM_ROCK,
+    ANIM_ROCK_SMALL,
+    ANIM_BULLET,
+    ANIM_PLAYER,
+    ANIM_PLAYER_GO,
+    ANIM_EXPLOSION_SHIP,
+    ANIM_UFO,
+    ANIM_COUNT
+};
+
+struct AnimClip {
+    const char *file; // the picture, frames laid out left to right in one row
+    int x, y, w, h; // where the first frame is and how big every frame is
+    int count; // number of frames
+    float speed; // frames advanced per tick
+};
+
+extern const AnimClip CLIPS[ANIM_COUNT];
+
+#endif
@@ -0,0 +1,25 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - ASSET PACKER
+// DESCRIPTION: Build step that decodes pictures and sounds once and writes the raw pixels and samples into
+// one pack file, so the game can map it in at startup instead of decoding JPG, PNG and OGG every time.
+// USAGE: asset_pack out.pack file...
+///////////////////////////////////////////////////
+
+#include "assets.h"
+
+#include <cstdio>
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("usage: asset_pack out.pack file...\n");
+        return 1;
+    }
+
+    std::vector<std::string> paths(argv + 2, argv + argc);
+    if (!writePack(argv[1], paths)) {
+        fprintf(stderr, "asset_pack: couldn't write %s\n", argv[1]);
+        return 1;
+    }
+    printf("packed %lu files into %s\n", (unsigned long) paths.size(), argv[1]);
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "assets.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <cstdlib>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint32_t PACK_VERSION = 1;
+const uint64_t PACK_ALIGN = 4096; // every entry starts on its own page
+
+bool isSound(const std::string &path) {
+    size_t dot = path.rfind('.');
+    std::string ext = dot == std::string::npos ? "" : path.substr(dot);
+    return ext == ".ogg" || ext == ".wav" || ext == ".flac";
+}
+
+}
+
+bool writePack(const char *out, const std::vector<std::string> &paths) {
+    std::vector<PackEntry> dir(paths.size());
+    std::vector<sf::Image> images(paths.size());
+    std::vector<sf::SoundBuffer> sounds(paths.size());
+
+    uint64_t offset = (sizeof(PackHeader) + dir.size() * sizeof(PackEntry) + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+    for (size_t i = 0; i < paths.size(); i++) {
+        PackEntry &e = dir[i];
+        memset(&e, 0, sizeof e);
+        if (paths[i].size() >= sizeof e.path) {
+            fprintf(stderr, "path too long for the pack: %s\n", paths[i].c_str());
+            return false;
+        }
+        strcpy(e.path, paths[i].c_str());
+
+        if (isSound(paths[i])) {
+            if (!sounds[i].loadFromFile(paths[i])) return false;
+            e.type = PACK_SOUND;
+            e.a = sounds[i].getChannelCount();
+            e.b = sounds[i].getSampleRate();
+            e.bytes = sounds[i].getSampleCount() * sizeof(sf::Int16);
+        } else {
+            if (!images[i].loadFromFile(paths[i])) return false;
+            e.type = PACK_IMAGE;
+            e.a = images[i].getSize().x;
+            e.b = images[i].getSize().y;
+            e.bytes = (uint64_t) e.a * e.b * 4;
+        }
+        e.offset = offset;
+        offset = (offset + e.bytes + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+    }
+
+    FILE *f = fopen(out, "wb");
+    if (!f) return false;
+
+    PackHeader h = {{'A', 'S', 'P', 'K'}, PACK_VERSION, (uint32_t) dir.size(), 0};
+    fwrite(&h, sizeof h, 1, f);
+    if (!dir.empty()) fwrite(&dir[0], sizeof(PackEntry), dir.size(), f);
+    for (size_t i = 0; i < dir.size(); i++) {
+        fseek(f, (long) dir[i].offset, SEEK_SET);
+        if (dir[i].type == PACK_SOUND) fwrite(sounds[i].getSamples(), 1, dir[i].bytes, f);
+        else fwrite(images[i].getPixelsPtr(), 1, dir[i].bytes, f);
+    }
+    return fclose(f) == 0;
+}
+
+Assets::Assets(int threads) : quit(false), pack(0), packBytes(0) {
+    for (int i = 0; i < threads; i++)
+        this->threads.push_back(std::thread(&Assets::worker, this));
+}
+
+Assets::~Assets() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        quit = true;
+    }
+    work.notify_all();
+    for (auto &t:threads)
+        t.join();
+    closePack();
+}
+
+bool Assets::openPack(const char *path) {
+    closePack();
+    unsigned char *data = 0;
+    size_t bytes = 0;
+
+#ifdef _WIN32 // no mmap, read the whole thing instead
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    bytes = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = (unsigned char *) malloc(bytes);
+    if (!data || fread(data, 1, bytes, f) != bytes) {
+        free(data);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        bytes = st.st_size;
+        void *p = mmap(0, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = p == MAP_FAILED ? 0 : (unsigned char *) p;
+    }
+    close(fd); // the mapping stays after the file is closed
+    if (!data) return false;
+#endif
+
+    pack = data;
+    packBytes = bytes;
+
+    const PackHeader *h = (const PackHeader *) pack;
+    if (bytes < sizeof(PackHeader) || memcmp(h->magic, "ASPK", 4) != 0 || h->version != PACK_VERSION ||
+        h->count > (bytes - sizeof(PackHeader)) / sizeof(PackEntry)) { // divided, a huge count can't wrap round
+        closePack();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m);
+    const PackEntry *dir = (const PackEntry *) (pack + sizeof(PackHeader));
+    for (uint32_t i = 0; i < h->count; i++) {
+        const PackEntry &e = dir[i];
+        // a damaged entry is left out: a path without its 0 would be read past the end, and an offset or size
+        // past the end of the file is checked without adding the two, which could wrap
+        if (e.path[sizeof e.path - 1] != 0 || e.offset > bytes || e.bytes > bytes - e.offset) continue;
+        packed[e.path] = &e;
+    }
+    return true;
+}
+
+void Assets::closePack() {
+    if (!pack) return;
+#ifdef _WIN32
+    free((void *) pack);
+#else
+    munmap((void *) pack, packBytes);
+#endif
+    pack = 0;
+    packBytes = 0;
+    packed.clear();
+}
+
+void Assets::request(const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (entries.count(path)) return;
+        entries[path].reset(new Entry());
+        entries[path]->state = QUEUED;
+        entries[path]->uploaded = false;
+        queue.push_back(path);
+    }
+    work.notify_one();
+}
+
+bool Assets::ready(const std::string &path) {
+    std::lock_guard<std::mutex> lock(m);
+    auto it = entries.find(path);
+    return it != entries.end() && it->second->state != QUEUED;
+}
+
+Assets::Entry *Assets::wait(const std::string &path) {
+    request(path);
+    std::unique_lock<std::mutex> lock(m);
+    Entry *e = entries[path].get();
+    loaded.wait(lock, [e] { return e->state != QUEUED; });
+    return e->state == LOADED ? e : 0;
+}
+
+const sf::Image *Assets::image(const std::string &path) {
+    Entry *e = wait(path);
+    return e ? &e->image : 0;
+}
+
+sf::Texture *Assets::texture(const std::string &path) {
+    Entry *e = wait(path);
+    if (!e) return 0;
+    if (!e->uploaded) {
+        if (!e->texture.loadFromImage(e->image)) return 0;
+        e->uploaded = true;
+    }
+    return &e->texture;
+}
+
+sf::SoundBuffer *Assets::sound(const std::string &path) {
+    Entry *e = wait(path);
+    return e ? &e->sound : 0;
+}
+
+sf::Font *Assets::font(const std::string &path) {
+    std::unique_ptr<sf::Font> &f = fonts[path];
+    if (!f) {
+        f.reset(new sf::Font());
+        if (!f->loadFromFile(path)) {
+            fonts.erase(path);
+            return 0;
+        }
+    }
+    return f.get();
+}
+
+void Assets::worker() {
+    for (;;) {
+        std::string path;
+        Entry *e;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            work.wait(lock, [this] { return quit || !queue.empty(); });
+            if (quit) return;
+            path = queue.front();
+            queue.pop_front();
+            e = entries[path].get();
+        }
+
+        bool ok = decode(path, *e); // the slow part, outside the lock
+
+        {
+            std::lock_guard<std::mutex> lock(m);
+            e->state = ok ? LOADED : FAILED;
+        }
+        loaded.notify_all();
+    }
+}
+
+bool Assets::decode(const std::string &path, Entry &e) {
+    const PackEntry *p = 0;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        auto it = packed.find(path);
+        if (it != packed.end()) p = it->second;
+    }
+
+    if (p) { // already decoded, just copy it out of the mapping
+        const unsigned char *data = pack + p->offset;
+        if (p->type == PACK_SOUND)
+            return e.sound.loadFromSamples((const sf::Int16 *) data, p->bytes / sizeof(sf::Int16), p->a, p->b);
+        e.image.create(p->a, p->b, data);
+        return true;
+    }
+
+    if (isSound(path)) return e.sound.loadFromFile(path);
+    return e.image.loadFromFile(path);
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - ASSET MANAGER
+// DESCRIPTION: Loads pictures, sounds and fonts once per path however many things use them. Pictures and
+// sounds are decoded by background threads as soon as they are requested, so the window can come up
+// straight away and things only needed later (the level 5 background) are loaded when the game gets close.
+// Textures are uploaded on the main thread the first time they are asked for, since that needs the GL context.
+// An asset pack made by asset_pack at build time holds the pixels and samples already decoded. When one is
+// open it is mapped into memory and those paths are copied out of it instead of decoding the JPG/PNG/OGG.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_ASSETS_H
+#define ASTEROIDS_ASSETS_H
+
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// asset pack layout: PackHeader, count PackEntry, then the data of each entry at its offset (page aligned)
+struct PackHeader {
+    char magic[4]; // "ASPK"
+    uint32_t version;
+    uint32_t count;
+    uint32_t pad;
+};
+
+struct PackEntry {
+    char path[112]; // as passed to the asset manager, "images/rock.png"
+    uint32_t type; // PACK_IMAGE or PACK_SOUND
+    uint32_t a, b; // image: width, height. sound: channels, sample rate
+    uint32_t pad;
+    uint64_t offset, bytes; // RGBA pixels or 16-bit samples
+};
+
+enum {PACK_IMAGE, PACK_SOUND};
+
+bool writePack(const char *out, const std::vector<std::string> &paths); // decodes every path into one pack file
+
+class Assets {
+public:
+    explicit Assets(int threads = 2);
+    ~Assets();
+
+    bool openPack(const char *path); // false when there isn't one, everything then comes from the files
+
+    void request(const std::string &path); // start decoding in the background, nothing happens the second time
+    bool ready(const std::string &path); // decoded, or failed to
+
+    // these wait for the decode if it hasn't finished, null if the file couldn't be loaded
+    const sf::Image *image(const std::string &path);
+    sf::Texture *texture(const std::string &path); // main thread only
+    sf::SoundBuffer *sound(const std::string &path);
+
+    sf::Font *font(const std::string &path); // main thread only. SFML reads glyphs as it needs them, this just opens the file
+
+private:
+    enum State {QUEUED, LOADED, FAILED};
+
+    struct Entry {
+        State state;
+        sf::Image image;
+        sf::SoundBuffer sound;
+        sf::Texture texture;
+        bool uploaded;
+    };
+
+    std::map<std::string, std::unique_ptr<Entry> > entries; // every path ever requested
+    std::map<std::string, std::unique_ptr<sf::Font> > fonts;
+    std::deque<std::string> queue; // waiting for a thread
+
+    std::mutex m;
+    std::condition_variable work, loaded;
+    std::vector<std::thread> threads;
+    bool quit;
+
+    // the mapped pack
+    const unsigned char *pack;
+    size_t packBytes;
+    std::map<std::string, const PackEntry *> packed;
+
+    Assets(const Assets &);
+    Assets &operator=(const Assets &);
+
+    void worker();
+    bool decode(const std::string &path, Entry &e);
+    Entry *wait(const std::string &path);
+    void closePack();
+};
+
+#endif
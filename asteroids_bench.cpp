@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SCENARIO BENCHMARK
+// DESCRIPTION: Runs the simulation through a fixed set of scenarios, each from the same seed every time:
+//   level1..level5   the game's own waves (15/15/25/34/45 rocks) with the scripted pilot flying
+//   split_cascade    the level 5 wave with a bullet dropped on every rock every tick, so everything splits and
+//                    dies as fast as it can, and a new wave comes in whenever the field is clear
+//   bullet_spam      level 1 with 500 bullets in the air at all times
+//   rocks_1k/10k/100k  big rock fields left to drift with the ship sitting still
+//   arena_10k/100k   the same numbers of rocks spread over scrolling arenas of 15 x 15 and 47 x 47 screens (level
+//                    5's density) with the pilot flying, where a tick should cost about the same for both
+// Each run plays the scenario's ticks twice from the same saved start. The first pass grows every array to the
+// most that run needs, the second is restored to the start and plays the very same ticks with nothing left to
+// grow, and is the one timed. Each scenario is run a few times and the fastest run is kept. Reported per
+// scenario: ns per tick overall and for each phase of World::step (integration = move, collision = grid build +
+// collide, which takes in apply hits, + apply commands, cleanup = compact, and every profiler scope on its own),
+// commands the collision handlers queued per tick, heap allocations per tick on the first pass, allocations on
+// the second (steady) and peak RSS.
+// A tick is meant to allocate nothing once the arrays have grown, so any scenario with steady allocations fails
+// the run (exit 1). --json file saves the results. --baseline file compares against results saved before and
+// fails as well when any scenario's ns per tick got worse by more than --threshold percent (10 by default).
+// USAGE: asteroids_bench [--json file] [--baseline file] [--threshold percent] [--repeat n] [--only name]
+///////////////////////////////////////////////////
+
+#include "profile.h"
+#include "world.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+namespace {
+
+const int WAVES[5] = {15, 15, 25, 34, 45}; // rocks at the start of each level
+const int MAX_PHASES = 32;
+
+void clearRocks(World &w) {
+    EntityArray &a = w.store.kinds[KIND_ASTEROID];
+    for (size_t i = 0; i < a.size(); i++)
+        a.life[i] = 0;
+    w.store.compact();
+    if (w.scrolling()) { // the parked ones too, the sectors around the camera stay active
+        w.sectors.clear();
+        w.sectors.focus(w.cameraX, w.cameraY, W, H);
+    }
+}
+
+void wave(World &w, int level) {
+    clearRocks(w);
+    w.level = level;
+    w.spawnRocks(WAVES[level - 1]);
+}
+
+void rockField(World &w, int rocks) {
+    clearRocks(w);
+    w.spawnRocks(rocks);
+}
+
+void shootEveryRock(World &w, int) {
+    EntityArray &a = w.store.kinds[KIND_ASTEROID];
+    if (a.size() == 0) w.spawnRocks(WAVES[4]);
+    for (size_t i = 0; i < a.size(); i++) // a still bullet right on top of it, hit on this tick's collision pass
+        w.store.create(KIND_BULLET, a.x[i], a.y[i], 0, 10, ANIM_BULLET);
+}
+
+void keepBulletsFlying(World &w, int bullets) {
+    EntityArray &pl = w.store.kinds[KIND_PLAYER];
+    int pi = w.store.find(w.p).index;
+    for (size_t n = w.store.kinds[KIND_BULLET].size(); n < (size_t) bullets; n++) {
+        float angle = (float) ((w.tick * 37 + n * 7) % 360); // fanned out all the way round
+        Handle h = w.store.create(KIND_BULLET, pl.x[pi], pl.y[pi], angle, 10, ANIM_BULLET);
+        EntityArray &b = w.store.kinds[KIND_BULLET];
+        int i = w.store.find(h).index;
+        b.dx[i] = std::cos(angle * DEGTORAD) * 6;
+        b.dy[i] = std::sin(angle * DEGTORAD) * 6;
+    }
+}
+
+struct Scenario {
+    const char *name;
+    unsigned long ticks;
+    void (*setup)(World &w, int arg);
+    int setupArg;
+    void (*everyTick)(World &w, int arg); // before each step, 0 for nothing
+    int tickArg;
+    bool flying; // the pilot flies, otherwise the ship sits still
+    int screens; // the arena is this many screens across and down
+};
+
+const Scenario SCENARIOS[] = {
+        {"level1", 10000, wave, 1, 0, 0, true, 1}, // ticks picked so each run takes a few tens of ms
+        {"level2", 10000, wave, 2, 0, 0, true, 1},
+        {"level3", 10000, wave, 3, 0, 0, true, 1},
+        {"level4", 10000, wave, 4, 0, 0, true, 1},
+        {"level5", 10000, wave, 5, 0, 0, true, 1},
+        {"split_cascade", 1000, wave, 5, shootEveryRock, 0, false, 1},
+        {"bullet_spam", 3000, wave, 1, keepBulletsFlying, 500, false, 1},
+        {"rocks_1k", 2000, rockField, 1000, 0, 0, false, 1},
+        {"rocks_10k", 300, rockField, 10000, 0, 0, false, 1},
+        {"rocks_100k", 30, rockField, 100000, 0, 0, false, 1},
+        {"arena_10k", 3000, rockField, 10000, 0, 0, true, 15},
+        {"arena_100k", 3000, rockField, 100000, 0, 0, true, 47},
+};
+
+struct Result {
+    std::string name;
+    unsigned long ticks;
+    double entities; // on average
+    double ns; // per tick, all of step()
+    double commands; // per tick, every type
+    double allocs; // per tick, on the first pass
+    unsigned long steadyAllocs; // on the second pass, should be 0
+    long peakKb;
+    std::vector<PhaseTotal> phases; // totals over the run, phaseNs() makes them per tick
+};
+
+void resetPeakRss() { // Linux lets the high water mark be reset, elsewhere the peak is for the whole run
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return;
+    fputs("5", f);
+    fclose(f);
+}
+
+long peakRssKb() {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (f) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof line, f))
+            if (sscanf(line, "VmHWM: %ld", &kb) == 1) break;
+        fclose(f);
+        if (kb >= 0) return kb;
+    }
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+void addTotals(std::vector<PhaseTotal> &sum) { // what the profiler has collected since the last call
+    PhaseTotal t[MAX_PHASES];
+    int n = profileTotals(t, MAX_PHASES);
+    for (int i = 0; i < n; i++) {
+        size_t j = 0;
+        while (j < sum.size() && strcmp(sum[j].name, t[i].name) != 0) j++;
+        if (j == sum.size()) sum.push_back(t[i]);
+        else {
+            sum[j].ns += t[i].ns;
+            sum[j].count += t[i].count;
+        }
+    }
+}
+
+double phaseNs(const Result &r, const char *name) {
+    for (auto &p:r.phases)
+        if (strcmp(p.name, name) == 0) return (double) p.ns / r.ticks;
+    return 0;
+}
+
+double collisionNs(const Result &r) { // finding the hits and carrying out what they asked for
+    return phaseNs(r, "grid build") + phaseNs(r, "collide") + phaseNs(r, "apply commands");
+}
+
+struct Pass { // one play through a scenario's ticks
+    double entities; // summed over the ticks
+    uint64_t ns;
+    unsigned long allocs, commands;
+};
+
+Pass play(World &world, const Scenario &s, std::vector<PhaseTotal> &phases) {
+    Pass p = {0, 0, 0, 0};
+    unsigned long commands = 0;
+    for (int t = 0; t < CMD_COUNT; t++)
+        commands += world.commands.totals[t];
+    profileTotals(0, 0); // forget whatever came before
+
+    for (unsigned long t = 0; t < s.ticks; t++) {
+        if (s.everyTick) s.everyTick(world, s.tickArg);
+        Input in = s.flying ? pilot(world.tick) : Input();
+        p.entities += world.store.size();
+
+        unsigned long a = heapAllocations();
+        auto start = std::chrono::steady_clock::now();
+        world.step(in);
+        p.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        p.allocs += heapAllocations() - a;
+
+        if (t % 256 == 255) addTotals(phases); // well before the ring wraps
+    }
+    addTotals(phases);
+
+    for (int t = 0; t < CMD_COUNT; t++)
+        p.commands += world.commands.totals[t];
+    p.commands -= commands;
+    return p;
+}
+
+Result run(const Scenario &s) {
+    World world(1, 60, s.screens, s.screens);
+    s.setup(world, s.setupArg);
+    std::vector<uint8_t> start;
+    world.save(start);
+    std::vector<PhaseTotal> phases;
+    phases.reserve(MAX_PHASES);
+
+    resetPeakRss();
+    Pass first = play(world, s, phases);
+    if (!world.restore(start.data(), start.size())) {
+        fprintf(stderr, "%s: can't restore the start\n", s.name);
+        exit(1);
+    }
+    phases.clear();
+    Pass steady = play(world, s, phases);
+
+    Result r;
+    r.name = s.name;
+    r.ticks = s.ticks;
+    r.entities = steady.entities / s.ticks;
+    r.ns = (double) steady.ns / s.ticks;
+    r.commands = (double) steady.commands / s.ticks;
+    r.allocs = (double) first.allocs / s.ticks;
+    r.steadyAllocs = steady.allocs;
+    r.peakKb = peakRssKb();
+    r.phases = phases;
+    return r;
+}
+
+void writeJson(FILE *f, const std::vector<Result> &results) {
+    fprintf(f, "{\n  \"scenarios\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ticks\": %lu, \"entities\": %.1f, \"ns_per_tick\": %.1f, "
+                   "\"commands_per_tick\": %.2f, \"allocs_per_tick\": %.4f, \"steady_allocs\": %lu, "
+                   "\"peak_rss_kb\": %ld,\n", r.name.c_str(), r.ticks, r.entities, r.ns, r.commands, r.allocs,
+                r.steadyAllocs, r.peakKb);
+        fprintf(f, "     \"phases\": {\"integration\": %.1f, \"collision\": %.1f, \"cleanup\": %.1f",
+                phaseNs(r, "move"), collisionNs(r),
+                phaseNs(r, "compact"));
+        for (auto &p:r.phases)
+            fprintf(f, ", \"%s\": %.1f", p.name, (double) p.ns / r.ticks);
+        fprintf(f, "}}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+bool baselineNs(const std::string &json, const std::string &name, double &ns) { // from a file writeJson() made
+    size_t at = json.find("\"name\": \"" + name + "\"");
+    if (at == std::string::npos) return false;
+    at = json.find("\"ns_per_tick\": ", at);
+    return at != std::string::npos && sscanf(json.c_str() + at, "\"ns_per_tick\": %lf", &ns) == 1;
+}
+
+}
+
+int main(int argc, char **argv) {
+    const char *jsonPath = 0, *baselinePath = 0, *only = 0;
+    double threshold = 10;
+    int repeat = 5;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--json") jsonPath = argv[i + 1];
+        else if (flag == "--baseline") baselinePath = argv[i + 1];
+        else if (flag == "--threshold") threshold = atof(argv[i + 1]);
+        else if (flag == "--repeat") repeat = atoi(argv[i + 1]);
+        else if (flag == "--only") only = argv[i + 1];
+    }
+    if (repeat < 1) repeat = 1;
+
+    std::string baseline;
+    if (baselinePath) {
+        FILE *f = fopen(baselinePath, "r");
+        if (!f) {
+            fprintf(stderr, "can't read baseline %s\n", baselinePath);
+            return 1;
+        }
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof buf, f)) > 0) baseline.append(buf, n);
+        fclose(f);
+    }
+
+    printf("%-14s %9s %11s %11s %11s %11s %9s %9s %7s %9s", "scenario", "entities", "ns/tick", "integrate",
+           "collide", "cleanup", "commands", "allocs", "steady", "peak MB");
+    if (baselinePath) printf(" %9s", "vs base");
+    printf("\n");
+
+    std::vector<Result> results;
+    bool regressed = false, allocating = false;
+    for (auto &s:SCENARIOS) {
+        if (only && strcmp(only, s.name) != 0) continue;
+        Result best = run(s);
+        for (int i = 1; i < repeat; i++) {
+            Result r = run(s);
+            if (r.ns < best.ns) best = r;
+        }
+
+        printf("%-14s %9.0f %11.0f %11.0f %11.0f %11.0f %9.2f %9.4f %7lu %9.1f", best.name.c_str(), best.entities,
+               best.ns, phaseNs(best, "move"), collisionNs(best), phaseNs(best, "compact"), best.commands, best.allocs,
+               best.steadyAllocs, best.peakKb / 1024.0);
+        if (best.steadyAllocs) {
+            printf("  ALLOCATES");
+            allocating = true;
+        }
+        double base;
+        if (baselinePath && baselineNs(baseline, best.name, base) && base > 0) {
+            double change = (best.ns / base - 1) * 100;
+            bool worse = change > threshold;
+            printf(" %+8.1f%%%s", change, worse ? "  REGRESSED" : "");
+            regressed = regressed || worse;
+        }
+        printf("\n");
+        results.push_back(best);
+    }
+
+    if (jsonPath) {
+        FILE *f = fopen(jsonPath, "w");
+        if (!f) {
+            fprintf(stderr, "can't write %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(f, results);
+        fclose(f);
+    }
+    if (allocating) printf("still allocating once every array has grown\n");
+    if (regressed) printf("slower than the baseline by more than %.0f%%\n", threshold);
+    if (allocating || regressed) return 1;
+    return 0;
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - COMMAND BUFFER
+// DESCRIPTION: What the collision handlers want done to the world, written down instead of done on the spot:
+// entities to spawn and destroy, points and lives won and lost, the ship put back in the middle, events for the
+// front end and effects to start. The world applies the whole buffer in one pass at the sync point after the
+// collision pass, in the order it was written, so nothing the pass is walking changes under it. Anything random
+// (a fragment's direction) is decided when the command is written.
+// That isn't quite the same as doing each one on the spot: what a command spawns only joins the world after
+// the pass, so fragments can't be hit on the tick they appear, and the ship is still where it crashed until the
+// sync point, so a handler that finds a respawn already queued for it leaves the ship alone.
+// The count of each type of command applied is kept per tick for the profiler and the runners.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_COMMANDS_H
+#define ASTEROIDS_COMMANDS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "entities.h"
+
+enum CommandType {
+    CMD_SPAWN, // an entity of kind at x, y with angle, R, clip and velocity dx, dy
+    CMD_DESTROY, // the entity at ref, gone at the next compact()
+    CMD_SCORE, // value points, a negative value is a penalty that stops at 0
+    CMD_EVENT, // a WorldEvent of type value at x, y
+    CMD_EFFECT, // an explosion of clip at x, y, with value pieces of debris
+    CMD_RESPAWN, // the entity at ref back in the middle of the arena, still, facing right
+    CMD_LIVES, // value lives, a negative value is lives lost
+    CMD_COUNT
+};
+
+struct Command {
+    uint8_t type, kind, clip;
+    int32_t value;
+    float x, y, angle, R, dx, dy;
+    Ref ref;
+};
+
+class CommandBuffer {
+public:
+    std::vector<Command> queue; // waiting for the sync point
+    unsigned long counts[CMD_COUNT]; // applied on the last tick
+    unsigned long totals[CMD_COUNT]; // applied since the game started
+
+    CommandBuffer() {
+        queue.reserve(256);
+        clear();
+    }
+
+    void clear() {
+        queue.clear();
+        for (int t = 0; t < CMD_COUNT; t++)
+            counts[t] = totals[t] = 0;
+    }
+
+    void spawn(int kind, float x, float y, float angle, float R, int clip, float dx, float dy) {
+        Command &c = push(CMD_SPAWN, x, y);
+        c.kind = kind;
+        c.clip = clip;
+        c.angle = angle;
+        c.R = R;
+        c.dx = dx;
+        c.dy = dy;
+    }
+
+    void destroy(Ref r) { push(CMD_DESTROY, 0, 0).ref = r; }
+    void score(int points) { push(CMD_SCORE, 0, 0).value = points; }
+    void event(int type, float x, float y) { push(CMD_EVENT, x, y).value = type; }
+
+    void effect(int clip, float x, float y, int debris) {
+        Command &c = push(CMD_EFFECT, x, y);
+        c.clip = clip;
+        c.value = debris;
+    }
+
+    void respawn(Ref r) { push(CMD_RESPAWN, 0, 0).ref = r; }
+    void lives(int n) { push(CMD_LIVES, 0, 0).value = n; }
+
+    bool respawning(Ref r) const { // a respawn of the entity at r is waiting for the sync point
+        for (auto &c:queue)
+            if (c.type == CMD_RESPAWN && c.ref.kind == r.kind && c.ref.index == r.index) return true;
+        return false;
+    }
+
+private:
+    Command &push(int type, float x, float y) {
+        Command c = {(uint8_t) type, 0, 0, 0, x, y, 0, 0, 0, 0, {0, 0}};
+        queue.push_back(c);
+        return queue.back();
+    }
+};
+
+#endif
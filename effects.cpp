@@ -0,0 +1,77 @@
+#include "effects.h"
+
+#include <cmath>
+
+const size_t Effects::CAPACITY;
+
+Effects::Effects() : step(1), emitted(0) {
+    x.resize(CAPACITY);
+    y.resize(CAPACITY);
+    dx.resize(CAPACITY);
+    dy.resize(CAPACITY);
+    angle.resize(CAPACITY);
+    spin.resize(CAPACITY);
+    frame.resize(CAPACITY);
+    speed.resize(CAPACITY);
+    life.resize(CAPACITY);
+    scale.resize(CAPACITY);
+    clip.resize(CAPACITY);
+}
+
+void Effects::clear() {
+    for (size_t i = 0; i < slots(); i++)
+        life[i] = 0;
+    emitted = 0;
+}
+
+size_t Effects::emit(float X, float Y, int Clip, float Life) {
+    size_t i = emitted++ & (CAPACITY - 1);
+    x[i] = X;
+    y[i] = Y;
+    dx[i] = dy[i] = 0;
+    angle[i] = spin[i] = 0;
+    frame[i] = 0;
+    speed[i] = CLIPS[Clip].speed;
+    life[i] = Life;
+    scale[i] = 1;
+    clip[i] = Clip;
+    return i;
+}
+
+void Effects::explosion(float X, float Y, int Clip) {
+    emit(X, Y, Clip, CLIPS[Clip].count / CLIPS[Clip].speed); // gone as the last frame ends
+}
+
+void Effects::debris(float X, float Y, int pieces) {
+    for (int n = 0; n < pieces; n++) {
+        size_t i = emit(X, Y, ANIM_ROCK_SMALL, 30 + rng.next() % 30);
+        float a = rng.next() % 360 * 0.017453f, v = 1 + rng.next() % 200 / 100.0f;
+        dx[i] = cos(a) * v;
+        dy[i] = sin(a) * v;
+        angle[i] = rng.next() % 360;
+        spin[i] = rng.next() % 11 - 5;
+        frame[i] = rng.next() % CLIPS[ANIM_ROCK_SMALL].count;
+        scale[i] = 0.15f + rng.next() % 15 / 100.0f;
+    }
+}
+
+void Effects::update(float dt) {
+    size_t n = slots();
+    for (size_t i = 0; i < n; i++) { // free slots too, cheaper than checking
+        float count = CLIPS[clip[i]].count;
+        x[i] += dx[i] * dt;
+        y[i] += dy[i] * dt;
+        angle[i] += spin[i] * dt;
+        frame[i] += speed[i] * dt;
+        if (frame[i] >= count) frame[i] -= count; // debris keeps spinning through its clip
+        life[i] -= dt;
+    }
+    step = dt;
+}
+
+size_t Effects::live() const {
+    size_t n = 0;
+    for (size_t i = 0; i < slots(); i++)
+        n += life[i] > 0;
+    return n;
+}
@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - EFFECTS
+// DESCRIPTION: Explosions and debris, kept apart from the entities. They never collide, nothing ever looks them
+// up, and they don't change how the game plays out, so they live in a fixed ring of CAPACITY effects with each
+// attribute in its own array. Emitting writes the next slot round the ring, over the oldest effect if the ring
+// is full, and one loop moves, animates and ages every slot each tick. Nothing is ever removed: an effect with
+// no life left is just skipped when drawing until its slot comes round again.
+// Debris is the small rock picture shrunk down and spinning off from where a rock split.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_EFFECTS_H
+#define ASTEROIDS_EFFECTS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "animation.h"
+#include "rng.h"
+
+class Effects {
+public:
+    static const size_t CAPACITY = 1024; // a power of two, the slot is the emit count masked
+
+    std::vector<float> x, y, dx, dy, angle, spin; // spin in degrees per tick
+    std::vector<float> frame, speed; // where it is in its clip and how fast it plays
+    std::vector<float> life; // 60 Hz frames left, <= 0 = slot free
+    std::vector<float> scale; // of the clip's picture
+    std::vector<unsigned char> clip; // AnimId
+    float step; // dt of the last update, for drawing between ticks
+
+    Effects(); // the whole ring, allocated once
+
+    void clear();
+    void reseed(uint64_t seed) { rng.reseed(seed); } // the debris' random directions, separate from the game's
+
+    void explosion(float x, float y, int clip); // plays clip through once where it is put
+    void debris(float x, float y, int pieces); // bits of rock flying off in every direction
+
+    void update(float dt); // dt in 60 Hz frames, like World::dt
+
+    size_t slots() const { return emitted < CAPACITY ? emitted : CAPACITY; } // every slot ever written is [0, slots())
+    size_t live() const; // effects with life left, for the stats overlay
+
+private:
+    size_t emitted;
+    Rng rng;
+
+    size_t emit(float x, float y, int clip, float life);
+};
+
+#endif
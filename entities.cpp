@@ -0,0 +1,299 @@
+#include "entities.h"
+
+#include <algorithm>
+#include <cstring>
+
+void EntityArray::push(float X, float Y, float Angle, float radius, int Clip, uint32_t Slot) {
+    x.push_back(X);
+    y.push_back(Y);
+    dx.push_back(0);
+    dy.push_back(0);
+    R.push_back(radius);
+    angle.push_back(Angle);
+    px.push_back(X); // new entities have nowhere to blend from
+    py.push_back(Y);
+    pangle.push_back(Angle);
+    clip.push_back(Clip);
+    frame.push_back(0);
+    speed.push_back(CLIPS[Clip].speed);
+    life.push_back(1);
+    slot.push_back(Slot);
+}
+
+void EntityArray::reserve(size_t n) {
+    x.reserve(n);
+    y.reserve(n);
+    dx.reserve(n);
+    dy.reserve(n);
+    R.reserve(n);
+    angle.reserve(n);
+    px.reserve(n);
+    py.reserve(n);
+    pangle.reserve(n);
+    clip.reserve(n);
+    frame.reserve(n);
+    speed.reserve(n);
+    life.reserve(n);
+    slot.reserve(n);
+}
+
+void EntityArray::swapRemove(size_t i) {
+    size_t last = size() - 1;
+    if (i != last) {
+        x[i] = x[last];
+        y[i] = y[last];
+        dx[i] = dx[last];
+        dy[i] = dy[last];
+        R[i] = R[last];
+        angle[i] = angle[last];
+        px[i] = px[last];
+        py[i] = py[last];
+        pangle[i] = pangle[last];
+        clip[i] = clip[last];
+        frame[i] = frame[last];
+        speed[i] = speed[last];
+        life[i] = life[last];
+        slot[i] = slot[last];
+    }
+    x.pop_back();
+    y.pop_back();
+    dx.pop_back();
+    dy.pop_back();
+    R.pop_back();
+    angle.pop_back();
+    px.pop_back();
+    py.pop_back();
+    pangle.pop_back();
+    clip.pop_back();
+    frame.pop_back();
+    speed.pop_back();
+    life.pop_back();
+    slot.pop_back();
+}
+
+void EntityArray::keepPosition() {
+    px.assign(x.begin(), x.end()); // same size as x and the capacity is already there, so no allocation
+    py.assign(y.begin(), y.end());
+}
+
+void EntityArray::keepAngle() {
+    pangle.assign(angle.begin(), angle.end());
+}
+
+void EntityStore::reserve(int kind, size_t n) {
+    kinds[kind].reserve(n);
+    stats[kind].capacity = kinds[kind].capacity();
+
+    size_t total = 0; // enough handle slots for every pool to be full at once
+    for (int k = 0; k < KIND_COUNT; k++)
+        total += kinds[k].capacity();
+    slots.reserve(total);
+    freeSlots.reserve(total);
+}
+
+void EntityStore::makeRoom(int kind, size_t n) {
+    EntityArray &arr = kinds[kind];
+    if (arr.size() + n <= arr.capacity()) return;
+    stats[kind].misses++; // one trip to the heap for the whole batch
+    reserve(kind, std::max(arr.size() + n, arr.capacity() * 2));
+}
+
+Handle EntityStore::create(int kind, float x, float y, float angle, float radius, int clip) {
+    EntityArray &arr = kinds[kind];
+    PoolStats &st = stats[kind];
+    if (arr.size() == arr.capacity()) { // full, this spawn grows the pool
+        st.misses++;
+        reserve(kind, arr.capacity() ? arr.capacity() * 2 : 16);
+    }
+    if (arr.size() + 1 > st.peak) st.peak = arr.size() + 1;
+
+    uint32_t s;
+    if (!freeSlots.empty()) { // reuse a dead entity's slot
+        s = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        s = slots.size();
+        Slot fresh = {0, 0, 0};
+        slots.push_back(fresh);
+    }
+
+    slots[s].kind = kind;
+    slots[s].index = arr.size();
+    arr.push(x, y, angle, radius, clip, s);
+
+    return Handle(s, slots[s].generation);
+}
+
+void EntityStore::release(int kind, size_t i) {
+    EntityArray &arr = kinds[kind];
+    uint32_t s = arr.slot[i];
+    slots[s].generation++; // every handle to it is now stale
+    freeSlots.push_back(s);
+
+    arr.swapRemove(i);
+    if (i < arr.size()) slots[arr.slot[i]].index = i; // the entity that moved into i
+}
+
+void EntityStore::compact() {
+    for (int k = 0; k < KIND_COUNT; k++) {
+        EntityArray &arr = kinds[k];
+        for (size_t i = 0; i < arr.size();) {
+            if (arr.life[i] == 0) release(k, i); // check i again, it holds the one that used to be last
+            else i++;
+        }
+    }
+}
+
+void EntityStore::clear() {
+    for (int k = 0; k < KIND_COUNT; k++) {
+        EntityArray &arr = kinds[k];
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.life[i] = 0;
+    }
+    compact();
+}
+
+size_t EntityStore::size() const {
+    size_t n = 0;
+    for (int k = 0; k < KIND_COUNT; k++)
+        n += kinds[k].size();
+    return n;
+}
+
+namespace {
+
+// the arrays of an entity kind in the order they are saved, f is called with each one
+template<class Array, class F>
+void eachColumn(Array &a, F &f) {
+    f(a.x);
+    f(a.y);
+    f(a.dx);
+    f(a.dy);
+    f(a.R);
+    f(a.angle);
+    f(a.px);
+    f(a.py);
+    f(a.pangle);
+    f(a.frame);
+    f(a.speed);
+    f(a.clip);
+    f(a.life);
+    f(a.slot);
+}
+
+struct RowBytes { // bytes one entity takes
+    size_t n;
+
+    template<class T>
+    void operator()(const std::vector<T> &) { n += sizeof(T); }
+};
+
+struct Put {
+    uint8_t *out;
+
+    template<class T>
+    void operator()(const std::vector<T> &v) {
+        memcpy(out, v.data(), v.size() * sizeof(T));
+        out += v.size() * sizeof(T);
+    }
+};
+
+struct Get {
+    const uint8_t *in;
+    size_t n;
+
+    template<class T>
+    void operator()(std::vector<T> &v) {
+        v.resize(n); // within the pool, it was reserved for this
+        memcpy(v.data(), in, n * sizeof(T));
+        in += n * sizeof(T);
+    }
+};
+
+size_t rowBytes() {
+    EntityArray a;
+    RowBytes b = {0};
+    eachColumn(a, b);
+    return b.n;
+}
+
+}
+
+size_t EntityStore::saveBytes() const {
+    size_t n = (KIND_COUNT + 2) * sizeof(uint32_t); // counts, slots, free slots
+    n += size() * rowBytes();
+    n += slots.size() * sizeof(Slot) + freeSlots.size() * sizeof(uint32_t);
+    return n;
+}
+
+uint8_t *EntityStore::save(uint8_t *out) const {
+    uint32_t counts[KIND_COUNT + 2];
+    for (int k = 0; k < KIND_COUNT; k++)
+        counts[k] = kinds[k].size();
+    counts[KIND_COUNT] = slots.size();
+    counts[KIND_COUNT + 1] = freeSlots.size();
+    memcpy(out, counts, sizeof counts);
+    out += sizeof counts;
+
+    Put put = {out};
+    for (int k = 0; k < KIND_COUNT; k++)
+        eachColumn(kinds[k], put);
+    out = put.out;
+
+    memcpy(out, slots.data(), slots.size() * sizeof(Slot));
+    out += slots.size() * sizeof(Slot);
+    memcpy(out, freeSlots.data(), freeSlots.size() * sizeof(uint32_t));
+    return out + freeSlots.size() * sizeof(uint32_t);
+}
+
+bool EntityStore::restore(const uint8_t *in, size_t n) {
+    uint32_t counts[KIND_COUNT + 2];
+    if (n < sizeof counts) return false;
+    memcpy(counts, in, sizeof counts);
+
+    size_t entities = 0;
+    for (int k = 0; k < KIND_COUNT; k++)
+        entities += counts[k];
+    if (n != sizeof counts + entities * rowBytes() + counts[KIND_COUNT] * sizeof(Slot) +
+             counts[KIND_COUNT + 1] * sizeof(uint32_t))
+        return false;
+    in += sizeof counts;
+
+    for (int k = 0; k < KIND_COUNT; k++) {
+        if (counts[k] > kinds[k].capacity()) { // saved from a bigger game than this pool has seen
+            stats[k].misses++;
+            reserve(k, counts[k]);
+        }
+        Get get = {in, counts[k]};
+        eachColumn(kinds[k], get);
+        in = get.in;
+        if (counts[k] > stats[k].peak) stats[k].peak = counts[k];
+    }
+
+    slots.resize(counts[KIND_COUNT]);
+    memcpy(slots.data(), in, slots.size() * sizeof(Slot));
+    in += slots.size() * sizeof(Slot);
+    freeSlots.resize(counts[KIND_COUNT + 1]);
+    memcpy(freeSlots.data(), in, freeSlots.size() * sizeof(uint32_t));
+
+    // a bad clip would index past CLIPS, a bad frame past its clip's pictures and a bad slot past the slots,
+    // any of them means a damaged file. the frame test is written so a NaN fails it too
+    bool ok = true;
+    for (int k = 0; k < KIND_COUNT && ok; k++) {
+        const EntityArray &a = kinds[k];
+        for (size_t i = 0; i < a.size() && ok; i++)
+            ok = a.clip[i] < ANIM_COUNT && a.frame[i] >= 0 && a.frame[i] < CLIPS[a.clip[i]].count &&
+                 a.slot[i] < slots.size() && slots[a.slot[i]].kind == k && slots[a.slot[i]].index == i;
+    }
+    for (size_t i = 0; i < freeSlots.size() && ok; i++)
+        ok = freeSlots[i] < slots.size();
+    if (!ok) {
+        for (int k = 0; k < KIND_COUNT; k++) {
+            Get none = {in, 0}; // every array back to empty
+            eachColumn(kinds[k], none);
+        }
+        slots.clear();
+        freeSlots.clear();
+    }
+    return ok;
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - ENTITY STORE
+// DESCRIPTION: Every entity in the game lives in one of these arrays, one set per kind of entity, with each
+// attribute in its own contiguous array (structure of arrays). An entity is removed by moving the last one of
+// its kind into its place, so the arrays never have holes. Handles stay valid across those moves and go stale
+// once their entity is gone.
+// Each array is also a pool: it is reserved up front for the worst case of its kind, removed entities leave
+// their storage behind for the next spawn, and nothing touches the heap until a pool runs out (a miss).
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_ENTITIES_H
+#define ASTEROIDS_ENTITIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "animation.h"
+
+enum Kind { // which array an entity lives in, also the order they are drawn in
+    KIND_ASTEROID,
+    KIND_UFO,
+    KIND_BULLET,
+    KIND_PLAYER,
+    KIND_COUNT
+};
+
+inline unsigned kindBit(int kind) { return 1u << kind; } // for sets of kinds
+
+struct Handle { // names one entity for as long as it is alive
+    uint32_t slot, generation;
+
+    Handle() : slot(~0u), generation(0) {}
+    Handle(uint32_t Slot, uint32_t Generation) : slot(Slot), generation(Generation) {}
+};
+
+struct Ref { // where an entity is right now, only good until the next compact()
+    int kind, index;
+};
+
+class EntityArray { // all the entities of one kind
+public:
+    std::vector<float> x, y, dx, dy, R, angle; // attributes of an entity (ie. asteroid, spaceship, ufo, bullet)
+    std::vector<float> px, py; // x, y before the last move, drawing blends from here and swept collision sweeps from here
+    std::vector<float> pangle; // angle at the start of the last tick
+    std::vector<unsigned char> clip; // AnimId of its animation
+    std::vector<float> frame, speed; // where it is in the clip and how fast it plays
+    std::vector<unsigned char> life; // whether or not the entity should be displayed, 0 = removed at the next compact()
+    std::vector<uint32_t> slot; // handle slot of each entity, to fix the handle up when the entity moves
+
+    size_t size() const { return x.size(); }
+    size_t capacity() const { return x.capacity(); }
+
+    void reserve(size_t n);
+
+    void push(float X, float Y, float Angle, float radius, int Clip, uint32_t Slot);
+    void swapRemove(size_t i); // last entity moves into i
+    void keepPosition(); // px, py = x, y
+    void keepAngle(); // pangle = angle
+};
+
+struct PoolStats { // for sizing the pools against the worst levels
+    size_t capacity; // entities the pool holds before it has to grow
+    size_t peak; // most alive at once
+    size_t misses; // spawns that found the pool full and had to go to the heap
+
+    PoolStats() : capacity(0), peak(0), misses(0) {}
+};
+
+class EntityStore {
+public:
+    EntityArray kinds[KIND_COUNT];
+    PoolStats stats[KIND_COUNT];
+
+    void reserve(int kind, size_t n); // sizes the pool for a kind
+    void makeRoom(int kind, size_t n); // n more spawns are coming, grows the pool once if they would not fit
+
+    // adds an entity with no velocity, the caller fills in dx/dy, its animation starts on the first frame
+    Handle create(int kind, float x, float y, float angle, float radius, int clip);
+
+    bool alive(Handle h) const {
+        return h.slot < slots.size() && slots[h.slot].generation == h.generation;
+    }
+
+    Ref find(Handle h) const { // where the entity is now, only for a handle that is alive()
+        Ref r = {slots[h.slot].kind, (int) slots[h.slot].index};
+        return r;
+    }
+
+    Handle handle(int kind, size_t i) const { // the other way round, the handle of entity i of a kind
+        uint32_t s = kinds[kind].slot[i];
+        return Handle(s, slots[s].generation);
+    }
+
+    void compact(); // removes every entity whose life has been set to 0
+    void clear();
+
+    // flat copy of every entity and handle slot for World::save(): counts, then each kind's arrays one after
+    // the other, then the slots. Restoring copies straight back into the pools, so handles stay good
+    size_t saveBytes() const;
+    uint8_t *save(uint8_t *out) const; // writes saveBytes(), returns the end
+    bool restore(const uint8_t *in, size_t n); // false if it isn't exactly one store, the store is then empty
+
+    size_t size() const;
+
+private:
+    struct Slot {
+        uint32_t generation; // bumped when the entity dies so old handles stop matching
+        int kind;
+        uint32_t index;
+    };
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+    void release(int kind, size_t i);
+};
+
+#endif
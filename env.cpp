@@ -0,0 +1,123 @@
+#include "env.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "replay.h"
+
+namespace {
+
+const size_t GAMES_PER_CHUNK = 8; // a step is a few microseconds, too little to hand out one game at a time
+
+float wrapped(float d, float size) { // shortest way across the wraparound
+    if (d > size / 2) return d - size;
+    if (d < -size / 2) return d + size;
+    return d;
+}
+
+}
+
+BatchEnv::BatchEnv(int worlds, JobPool *pool, int hz) : games(worlds), pool(pool) {
+    for (int i = 0; i < worlds; i++) {
+        games[i].dist.reserve(512); // room for a full rock pool and the ufos
+        games[i].order.reserve(512);
+        games[i].world.reset(new World(i + 1, hz));
+    }
+}
+
+void BatchEnv::reset(const unsigned int *seeds) {
+    for (int i = 0; i < size(); i++)
+        reset(i, seeds[i]);
+}
+
+void BatchEnv::reset(int i, unsigned int seed) {
+    games[i].world->reset(seed);
+}
+
+void BatchEnv::step(const unsigned char *actions, float *obs, float *rewards, unsigned char *done) {
+    StepArgs a = {actions, obs, rewards, done};
+    size_t n = games.size();
+    if (!pool) {
+        for (size_t i = 0; i < n; i++)
+            stepOne((int) i, a);
+        return;
+    }
+
+    const StepArgs *args = &a;
+    pool->parallelFor(n, GAMES_PER_CHUNK, [this, args](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            stepOne((int) i, *args);
+    });
+}
+
+void BatchEnv::observe(float *obs) {
+    for (int i = 0; i < size(); i++)
+        observe(i, obs + (size_t) i * ENV_OBS);
+}
+
+void BatchEnv::stepOne(int i, const StepArgs &a) {
+    World &w = *games[i].world;
+    bool over = w.lives <= 0;
+
+    unsigned int before = w.score;
+    if (!over) {
+        w.step(inputFromBits(a.actions ? a.actions[i] : 0));
+        over = w.lives <= 0;
+    }
+
+    if (a.rewards) a.rewards[i] = (float) w.score - (float) before;
+    if (a.done) a.done[i] = over ? 1 : 0;
+    if (a.obs) observe(i, a.obs + (size_t) i * ENV_OBS);
+}
+
+void BatchEnv::observe(int i, float *out) {
+    Game &g = games[i];
+    const World &w = *g.world;
+    const EntityArray &pl = w.store.kinds[KIND_PLAYER];
+    int pi = w.store.find(w.p).index;
+    float x = pl.x[pi], y = pl.y[pi];
+
+    out[0] = x / W * 2 - 1;
+    out[1] = y / H * 2 - 1;
+    out[2] = pl.dx[pi] / 15; // the ship tops out at 15 a frame
+    out[3] = pl.dy[pi] / 15;
+    out[4] = std::cos(pl.angle[pi] * DEGTORAD);
+    out[5] = std::sin(pl.angle[pi] * DEGTORAD);
+    out[6] = w.lives / 3.0f; // a game starts with 3 and is done at 0
+    out[7] = (w.level - 1) / 4.0f; // levels 1 to 5, the game stays on 5 once it gets there
+
+    // rocks first then ufos, numbered one after the other
+    const EntityArray &A = w.store.kinds[KIND_ASTEROID], &U = w.store.kinds[KIND_UFO];
+    int nA = (int) A.size(), n = nA + (int) U.size();
+    g.dist.resize(n); // within the reserved room unless the pools grew
+    g.order.resize(n);
+    for (int j = 0; j < n; j++) {
+        const EntityArray &e = j < nA ? A : U;
+        int k = j < nA ? j : j - nA;
+        float ox = wrapped(e.x[k] - x, W), oy = wrapped(e.y[k] - y, H);
+        g.dist[j] = ox * ox + oy * oy;
+        g.order[j] = j;
+    }
+
+    int m = std::min(n, ENV_NEAREST);
+    const std::vector<float> &dist = g.dist;
+    std::partial_sort(g.order.begin(), g.order.begin() + m, g.order.end(),
+                      [&dist](int a, int b) { return dist[a] < dist[b] || (dist[a] == dist[b] && a < b); });
+
+    float *slot = out + 8;
+    for (int s = 0; s < ENV_NEAREST; s++, slot += ENV_SLOT) {
+        if (s >= m) {
+            std::fill(slot, slot + ENV_SLOT, 0.0f);
+            continue;
+        }
+        int j = g.order[s];
+        const EntityArray &e = j < nA ? A : U;
+        int k = j < nA ? j : j - nA;
+        slot[0] = wrapped(e.x[k] - x, W) / (W / 2);
+        slot[1] = wrapped(e.y[k] - y, H) / (H / 2);
+        slot[2] = e.dx[k] / 4; // rocks move up to 4 a frame, ufos up to 5
+        slot[3] = e.dy[k] / 4;
+        slot[4] = e.R[k] / 40; // a ufo is the biggest
+        slot[5] = j < nA ? 0.0f : 1.0f;
+    }
+}
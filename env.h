@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - BATCHED ENVIRONMENT
+// DESCRIPTION: Runs K independent games in lockstep for agents to play, all in one process with no window,
+// textures or sounds. reset() starts every game from its own seed, step() takes one action per game and
+// writes what happened into flat arrays the caller owns:
+//   obs      K * ENV_OBS floats, see below
+//   rewards  K floats, the change in score over the step (+33 rock, +75 ufo, -15/-20 for crashing)
+//   done     K bytes, 1 once the game is out of lives. A finished game stands still until reset(i, seed)
+// The games are spread over a JobPool a few at a time. Each one has its own Rng, so the results don't depend
+// on the thread count, and nothing is allocated while stepping or resetting once every game has warmed up.
+// Observation of one game, positions and speeds scaled to roughly -1..1:
+//   [0..7]   player x, y, dx, dy, cos and sin of its heading, lives (3 = 1, 0 = 0), level (1 = 0, 5 = 1)
+//   then ENV_NEAREST slots of ENV_SLOT floats for the closest rocks and ufos, nearest first, measured across
+//   the wraparound: offset x, y from the player, dx, dy, radius, 1 for a ufo. Unused slots are all 0
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_ENV_H
+#define ASTEROIDS_ENV_H
+
+#include <memory>
+#include <vector>
+
+#include "jobs.h"
+#include "world.h"
+
+const int ENV_NEAREST = 8;
+const int ENV_SLOT = 6;
+const int ENV_OBS = 8 + ENV_NEAREST * ENV_SLOT;
+
+class BatchEnv {
+public:
+    BatchEnv(int worlds, JobPool *pool = 0, int hz = 60); // pool = 0 steps everything on the calling thread
+
+    int size() const { return (int) games.size(); }
+
+    void reset(const unsigned int *seeds); // one seed per game
+    void reset(int i, unsigned int seed); // just game i, for starting a new game in a finished one's place
+
+    // actions = K input bytes as from inputBits(), any of the pointers can be 0 if the caller doesn't want it
+    void step(const unsigned char *actions, float *obs, float *rewards, unsigned char *done);
+
+    void observe(float *obs); // obs of every game as they are now, for right after a reset
+
+    const World &world(int i) const { return *games[i].world; }
+
+private:
+    struct Game {
+        std::unique_ptr<World> world;
+        std::vector<float> dist; // scratch for finding the nearest things, kept between steps
+        std::vector<int> order;
+    };
+
+    struct StepArgs { // what the workers need, passed by pointer so the job fits in std::function without allocating
+        const unsigned char *actions;
+        float *obs, *rewards;
+        unsigned char *done;
+    };
+
+    std::vector<Game> games;
+    JobPool *pool;
+
+    void stepOne(int i, const StepArgs &a);
+    void observe(int i, float *out);
+
+    BatchEnv(const BatchEnv &);
+    BatchEnv &operator=(const BatchEnv &);
+};
+
+#endif
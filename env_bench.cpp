@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - BATCHED ENVIRONMENT BENCHMARK
+// DESCRIPTION: Plays K games at once through BatchEnv with a random agent (each game holds a random action for
+// a few ticks) for a number of steps. A game that runs out of lives is started again with a new seed, and one
+// still going after ten minutes of game time is cut off the same way. Reports steps per second across all the
+// games, how many games finished per second, and the heap allocations made while stepping and resetting (a
+// game allocates on its first few steps, after that never).
+// USAGE: env_bench [games] [steps] [threads]
+///////////////////////////////////////////////////
+
+#include "env.h"
+#include "profile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+    int games = argc > 1 ? atoi(argv[1]) : 256;
+    long steps = argc > 2 ? atol(argv[2]) : 5000;
+    int threads = argc > 3 ? atoi(argv[3]) : (int) std::thread::hardware_concurrency();
+    if (games < 1) games = 1;
+    if (threads < 1) threads = 1;
+    const unsigned long cap = 60 * 60 * 10; // ticks, ten minutes at 60 Hz
+
+    JobPool pool(threads);
+    BatchEnv env(games, &pool);
+
+    std::vector<unsigned int> seeds(games);
+    for (int i = 0; i < games; i++)
+        seeds[i] = i + 1;
+    unsigned int nextSeed = games + 1;
+    env.reset(seeds.data());
+
+    std::vector<float> obs((size_t) games * ENV_OBS), rewards(games), returns(games, 0.0f);
+    std::vector<unsigned char> actions(games, 0), done(games, 0);
+    Rng agent(12345);
+
+    long finished = 0, cut = 0;
+    double totalReturn = 0, totalLength = 0;
+    unsigned long stepAllocations = 0;
+
+    env.observe(obs.data());
+    auto start = std::chrono::steady_clock::now();
+    for (long s = 0; s < steps; s++) {
+        for (int i = 0; i < games; i++)
+            if (agent.next() % 8 == 0) actions[i] = (unsigned char) (agent.next() & 15);
+
+        unsigned long before = heapAllocations();
+        env.step(actions.data(), obs.data(), rewards.data(), done.data());
+
+        for (int i = 0; i < games; i++) {
+            returns[i] += rewards[i];
+            bool over = done[i] || env.world(i).tick >= cap;
+            if (!over) continue;
+
+            if (done[i]) finished++;
+            else cut++;
+            totalReturn += returns[i];
+            totalLength += env.world(i).tick;
+            returns[i] = 0;
+            env.reset(i, nextSeed++);
+        }
+        stepAllocations += heapAllocations() - before;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double total = (double) steps * games;
+    printf("%d games, %ld steps each, %d threads, %d floats of observation per game\n", games, steps, pool.size(),
+           ENV_OBS);
+    printf("%.3f s, %.0f steps/s, %.1f games/s (%ld finished, %ld cut off at %lu ticks)\n", elapsed.count(),
+           total / elapsed.count(), (finished + cut) / elapsed.count(), finished, cut, cap);
+    if (finished + cut)
+        printf("average game: %.0f ticks, %.1f points\n", totalLength / (finished + cut),
+               totalReturn / (finished + cut));
+    printf("%lu heap allocations while stepping and resetting, %.4f per step\n", stepAllocations,
+           stepAllocations / total);
+    return 0;
+}
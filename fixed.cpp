@@ -0,0 +1,75 @@
+#include "fixed.h"
+
+#include <cmath>
+
+namespace {
+
+const int QUARTERS = 360; // table steps in 90 degrees
+
+struct SinTable {
+    int32_t v[QUARTERS + 1]; // sin 0 .. sin 90 in 1/65536ths, the other three quarters are the same mirrored
+};
+
+constexpr SinTable makeSinTable() { // Taylor series, worked out by the compiler once
+    SinTable t{};
+    for (int i = 0; i <= QUARTERS; i++) {
+        double r = i * (3.14159265358979323846 / 2 / QUARTERS), term = r, sum = r;
+        for (int k = 1; k < 12; k++) {
+            term *= -r * r / ((2 * k) * (2 * k + 1));
+            sum += term;
+        }
+        t.v[i] = (int32_t) (sum * 65536 + 0.5);
+    }
+    return t;
+}
+
+constexpr SinTable SIN = makeSinTable();
+static_assert(SIN.v[0] == 0 && SIN.v[120] == 32768 && SIN.v[240] == 56756 && SIN.v[QUARTERS] == 65536,
+              "sine table is off");
+
+int32_t sinQuarters(int32_t q) { // q in quarter degrees, any sign
+    q %= 4 * QUARTERS;
+    if (q < 0) q += 4 * QUARTERS;
+    int32_t j = q % QUARTERS;
+    switch (q / QUARTERS) {
+        case 0: return SIN.v[j];
+        case 1: return SIN.v[QUARTERS - j];
+        case 2: return -SIN.v[j];
+        default: return -SIN.v[QUARTERS - j];
+    }
+}
+
+}
+
+int32_t fixSin(float degrees) {
+    return sinQuarters((int32_t) (degrees * 4));
+}
+
+int32_t fixCos(float degrees) {
+    return sinQuarters((int32_t) (degrees * 4) + QUARTERS);
+}
+
+uint32_t isqrt(uint64_t v) {
+    uint64_t r = (uint64_t) std::sqrt((double) v); // only a guess, put right in integers so the answer is exact
+    if (r > 0xFFFFFFFFull) r = 0xFFFFFFFFull;
+    while (r * r > v) r--;
+    while (r < 0xFFFFFFFFull && (r + 1) * (r + 1) <= v) r++;
+    return (uint32_t) r;
+}
+
+static void multiply(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) { // 64 x 64 -> 128 in 32-bit halves
+    uint64_t al = (uint32_t) a, ah = a >> 32, bl = (uint32_t) b, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = (ll >> 32) + (uint32_t) lh + (uint32_t) hl;
+    lo = (mid << 32) | (uint32_t) ll;
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+}
+
+bool lessProduct(uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+    uint64_t h1, l1, h2, l2;
+    multiply(a, b, h1, l1);
+    multiply(c, d, h2, l2);
+    return h1 < h2 || (h1 == h2 && l1 < l2);
+}
+
+const char *mathName() { return FIXED_MATH ? "fixed" : "float"; }
@@ -0,0 +1,75 @@
+#include "grid.h"
+
+void Grid::build(const EntityStore &store, unsigned layers, int width, int height) {
+    size_t total = 0;
+    for (int k = 0; k < KIND_COUNT; k++)
+        if (layers & kindBit(k)) total += store.kinds[k].size();
+
+    for (int k = 0; k < KIND_COUNT; k++) {
+        maxR[k] = 0;
+        if (!(layers & kindBit(k))) continue;
+        const EntityArray &arr = store.kinds[k];
+        for (size_t i = 0; i < arr.size(); i++)
+            if (arr.R[i] > maxR[k]) maxR[k] = arr.R[i];
+    }
+
+    roundX = wrapW > 0 && width >= wrapW;
+    roundY = wrapH > 0 && height >= wrapH;
+    cols = roundX ? int(wrapW / cell + 0.5f) : int(width / cell) + 1;
+    rows = roundY ? int(wrapH / cell + 0.5f) : int(height / cell) + 1;
+
+    size_t count = (size_t) cols * rows * KIND_COUNT;
+    if (buckets.size() != count) { // only when the area covered changes size
+        Bucket empty = {0, 0, 0};
+        buckets.assign(count, empty);
+        touched.reserve(count);
+        epoch = 0;
+    }
+    if (++epoch == 0) { // wrapped after 4 billion builds, start the stamps again
+        for (auto &b:buckets)
+            b.stamp = 0;
+        epoch = 1;
+    }
+    if (items.capacity() < total) { // headroom so a few more entities next tick don't mean growing again
+        items.reserve(total * 2);
+        cellIndex.reserve(total * 2);
+    }
+    cellIndex.resize(total);
+    items.resize(total);
+    touched.clear();
+
+    int n = 0;
+    for (int k = 0; k < KIND_COUNT; k++) { // count how many land in each bucket
+        if (!(layers & kindBit(k))) continue;
+        const EntityArray &arr = store.kinds[k];
+        for (size_t i = 0; i < arr.size(); i++) {
+            int c = (cellOf(local(arr.y[i], y0, wrapH), rows, roundY) * cols +
+                     cellOf(local(arr.x[i], x0, wrapW), cols, roundX)) * KIND_COUNT + k;
+            Bucket &b = buckets[c];
+            if (b.stamp != epoch) {
+                b.stamp = epoch;
+                b.end = 0;
+                touched.push_back(c);
+            }
+            b.end++;
+            cellIndex[n++] = c;
+        }
+    }
+    int at = 0;
+    for (int c:touched) { // a run of items for each bucket that got anything, in the order they were first hit
+        Bucket &b = buckets[c];
+        b.start = at;
+        at += b.end;
+        b.end = b.start;
+    }
+
+    n = 0; // then drop each one into the next free slot of its bucket
+    for (int k = 0; k < KIND_COUNT; k++) {
+        if (!(layers & kindBit(k))) continue;
+        const EntityArray &arr = store.kinds[k];
+        for (size_t i = 0; i < arr.size(); i++) {
+            Ref r = {k, (int) i};
+            items[buckets[cellIndex[n++]].end++] = r;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - BROADPHASE
+// DESCRIPTION: Uniform grid over the play field. Every entity is bucketed into one cell at the start of the
+// collision pass, and an entity only gets tested against the few cells around it that something could reach it
+// from, instead of against everything on screen.
+// A build only touches the cells something lands in: every cell remembers the build that last filled it and
+// counts as empty for any other, so nothing has to be cleared between ticks however many cells there are.
+// In an arena that scrolls the grid only covers the sectors around the camera, measured round the arena's
+// edges from their corner, so it stays the size of the screen however big the arena is. When those sectors
+// reach all the way round the arena the grid's cells wrap round its seam as well, so things touching across
+// it share a neighbourhood (arenas are whole sectors, so whole cells).
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_GRID_H
+#define ASTEROIDS_GRID_H
+
+#include <cmath>
+#include <vector>
+
+#include "entities.h"
+
+class Grid {
+public:
+    explicit Grid(float cellSize) : cell(cellSize), cols(1), rows(1), x0(0), y0(0), wrapW(0), wrapH(0),
+                                    roundX(false), roundY(false), epoch(0) {
+        for (int k = 0; k < KIND_COUNT; k++) maxR[k] = 0;
+    }
+
+    // the next build() covers width x height from x, y on, in an arena of arenaW x arenaH that wraps (0 = the
+    // grid starts at 0, 0 and nothing wraps, the classic screen)
+    void place(float x, float y, float arenaW, float arenaH) {
+        x0 = x;
+        y0 = y;
+        wrapW = arenaW;
+        wrapH = arenaH;
+    }
+
+    void build(const EntityStore &store, unsigned layers, int width, int height); // buckets the entities of the kinds in layers by cell
+
+    // calls f(b) for every entity of a kind in mask that could touch a circle of radius R at x,y
+    template<class F>
+    void query(Ref a, float x, float y, float R, unsigned mask, F f) const {
+        for (int kind = 0; kind < KIND_COUNT; kind++) {
+            if (!(mask & kindBit(kind))) continue;
+
+            float reach = R + maxR[kind]; // nothing of this kind further away than this can overlap
+            int i0, i1, j0, j1;
+            span(local(x, x0, wrapW), reach, cols, roundX, i0, i1);
+            span(local(y, y0, wrapH), reach, rows, roundY, j0, j1);
+            for (int j = j0; j <= j1; j++)
+                for (int i = i0; i <= i1; i++) {
+                    int ci = roundX ? wrapCell(i, cols) : i, cj = roundY ? wrapCell(j, rows) : j;
+                    const Bucket &b = buckets[(cj * cols + ci) * KIND_COUNT + kind];
+                    if (b.stamp != epoch) continue; // nothing landed here on this build
+                    for (int k = b.start; k < b.end; k++)
+                        if (!same(items[k], a)) f(items[k]);
+                }
+        }
+    }
+
+private:
+    float cell;
+    int cols, rows;
+    float x0, y0, wrapW, wrapH; // see place()
+    bool roundX, roundY; // the last build() covered the whole arena across / down, its cells wrap round the seam
+    float maxR[KIND_COUNT]; // biggest radius of each kind in the grid
+    struct Bucket {
+        unsigned stamp; // the build that filled it, any other and the bucket is empty
+        int start, end; // its entities are items[start .. end)
+    };
+    // every cell is split by kind: buckets[c * KIND_COUNT + k] holds the entities of kind k in cell c, so a query
+    // only walks the kinds it cares about
+    std::vector<Bucket> buckets;
+    unsigned epoch; // bumped by every build()
+    std::vector<Ref> items;
+    std::vector<int> cellIndex, touched; // scratch for build(): each entity's bucket, the buckets filled
+
+    static bool same(Ref a, Ref b) { return a.kind == b.kind && a.index == b.index; }
+
+    static float local(float v, float origin, float wrap) { // v measured from the grid's corner
+        v -= origin;
+        if (wrap && v < 0) v += wrap; // round the arena
+        if (wrap && v >= wrap) v -= wrap;
+        return v;
+    }
+
+    static int wrapCell(int c, int n) {
+        c %= n;
+        return c < 0 ? c + n : c;
+    }
+
+    // cells v - reach .. v + reach covers, as i0 <= i1. On an axis that goes round, they can run off either end
+    // and wrapCell() brings them back
+    void span(float v, float reach, int n, bool round, int &i0, int &i1) const {
+        if (!round) {
+            i0 = cellOf(v - reach, n);
+            i1 = cellOf(v + reach, n);
+            return;
+        }
+        i0 = (int) std::floor((v - reach) / cell);
+        i1 = (int) std::floor((v + reach) / cell);
+        if (i1 - i0 >= n) { // reaches all the way round, every cell once
+            i0 = 0;
+            i1 = n - 1;
+        }
+    }
+
+    int cellOf(float v, int n, bool round) const { // for build(), where v is already inside the grid
+        return round ? wrapCell(int(v / cell), n) : cellOf(v, n);
+    }
+
+    int cellOf(float v, int n) const {
+        // anything sitting on the far edge (x == W after wrapping) or already off screen (bullets, the ufo)
+        // goes in the nearest edge cell. On the classic screen the narrow phase measures straight distance, so
+        // things on opposite sides of the wraparound seam never touch and the grid doesn't need to wrap either
+        int c = int(v / cell);
+        if (v < 0) c = 0;
+        if (c >= n) c = n - 1;
+        return c;
+    }
+};
+
+#endif
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - HEADLESS RUNNER
+// DESCRIPTION: Plays the game with no window, sound or GPU. A scripted pilot flies the ship for a number of
+// frames from a fixed seed and the runner reports how many ticks per second the simulation managed.
+// threads = 0 runs the same game once for every thread count from 1 up, to show the scaling and that the
+// final state hash never changes.
+// The game can also tick at 120 or 240 Hz, with the pilot's inputs spread out to match.
+// --record saves the pilot's game as a replay (without extra rocks, those aren't in the file). --replay plays
+// a recording from here or from the game as fast as it goes and checks every hash in it along the way.
+// --ccd turns on swept collision, which lets the game tick at 30 Hz without fast things tunnelling.
+// --arena n plays in an arena n screens across and n down, with the camera on the ship and the rocks away from
+// it parked in their sectors (extra rocks are spread over the whole arena).
+// --trace saves where the time went as a Chrome trace (debug builds, or with ASTEROIDS_PROFILE).
+// Asteroids_sim_fixed is this runner built on the fixed point simulation, the same arguments time it against
+// the float one.
+// USAGE: Asteroids_sim [--ccd] [--arena n] [--record file] [--trace file] [frames] [seed] [extra rocks] [threads]
+//                      [hz]
+//        Asteroids_sim --replay file [threads]
+///////////////////////////////////////////////////
+
+#include "fixed.h"
+#include "profile.h"
+#include "replay.h"
+#include "world.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+static const char *kindNames[KIND_COUNT] = {"asteroid", "ufo", "bullet", "player"};
+static const char *commandNames[CMD_COUNT] = {"spawn", "destroy", "score", "event", "effect", "respawn", "lives"};
+
+int hz = 60;
+
+int replay(const char *path, int threads) {
+    ReplayReader rec;
+    if (!rec.open(path)) {
+        printf("can't read replay %s\n", path);
+        return 1;
+    }
+
+    JobPool pool(threads);
+    World world(rec.seed, rec.hz, rec.across, rec.down);
+    world.jobs = &pool;
+    world.continuous = rec.continuous;
+    rec.check(world);
+
+    Input in;
+    auto start = std::chrono::steady_clock::now();
+    while (rec.divergedAt < 0 && rec.next(in)) {
+        world.step(in);
+        rec.check(world);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("replay %s: seed %u hz %d threads %d\n", path, rec.seed, rec.hz, pool.size());
+    printf("%lu ticks (%.1f s of game) in %.3f s, %.0f ticks/s\n", world.tick, (double) world.tick / rec.hz,
+           elapsed.count(), world.tick / elapsed.count());
+    printf("score %u level %u lives %d\n", world.score, world.level, world.lives);
+    if (rec.divergedAt >= 0) {
+        printf("DIVERGED at tick %ld, %lu checks passed before it\n", rec.divergedAt, rec.checks);
+        return 2;
+    }
+    printf("%lu hash checks passed\n", rec.checks);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *recordPath = 0, *tracePath = 0;
+    bool continuous = false;
+    int arena = 1;
+    if (argc > 2 && std::string(argv[1]) == "--replay")
+        return replay(argv[2], argc > 3 ? atoi(argv[3]) : 1);
+    while (argc > 1 && std::string(argv[1]).compare(0, 2, "--") == 0) { // the rest are the usual arguments
+        std::string flag = argv[1];
+        if (flag == "--ccd") {
+            continuous = true;
+            argc--;
+            argv++;
+            continue;
+        }
+        if (argc < 3 || (flag != "--record" && flag != "--trace" && flag != "--arena")) break;
+        if (flag == "--arena") arena = std::max(1, std::min(100, atoi(argv[2]))); // fits the replay header's byte
+        else (flag == "--record" ? recordPath : tracePath) = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+
+    unsigned long frames = argc > 1 ? strtoul(argv[1], 0, 10) : 100000;
+    if (frames == 0) { // also what strtoul makes of something that isn't a number, every rate below divides by it
+        printf("frames has to be a number above 0, not %s\n", argv[1]);
+        return 1;
+    }
+    unsigned int seed = argc > 2 ? strtoul(argv[2], 0, 10) : 1;
+
+    int rocks = argc > 3 && !recordPath ? atoi(argv[3]) : 0;
+    int threads = argc > 4 ? atoi(argv[4]) : 1;
+    hz = argc > 5 ? atoi(argv[5]) : 60;
+    if (!supportedHz(hz)) hz = 60; // 30 for big batches, with --ccd
+
+    if (threads == 0) { // scaling table
+        int most = std::max(4, (int) std::thread::hardware_concurrency());
+        printf("frames %lu seed %u rocks %d, %u hardware threads\n", frames, seed, rocks,
+               std::thread::hardware_concurrency());
+        printf("threads   ticks/s  speedup  hash\n");
+        double first = 0;
+        for (int t = 1; t <= most; t++) {
+            JobPool pool(t);
+            World world(seed, hz, arena, arena);
+            world.jobs = &pool;
+            world.continuous = continuous;
+            world.spawnRocks(rocks);
+
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned long i = 0; i < frames; i++)
+                world.step(pilot(world.tick, hz));
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            double rate = frames / elapsed.count();
+            if (t == 1) first = rate;
+            printf("%7d %9.0f %7.2fx  %016llx\n", t, rate, rate / first, (unsigned long long) world.hash());
+        }
+        return 0;
+    }
+
+    JobPool pool(threads);
+    World world(seed, hz, arena, arena);
+    world.jobs = &pool;
+    world.continuous = continuous;
+    world.spawnRocks(rocks); // stress test on top of the normal level 1 wave
+
+    ReplayWriter rec;
+    if (recordPath && !rec.open(recordPath, world, seed)) {
+        printf("can't write replay %s\n", recordPath);
+        return 1;
+    }
+
+    unsigned long allocsBefore = heapAllocations();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < frames; i++) {
+        Input in = pilot(world.tick, hz);
+        world.step(in);
+        rec.record(in, world);
+        profileFrame();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    unsigned long allocs = heapAllocations() - allocsBefore;
+
+    printf("frames %lu seed %u threads %d hz %d%s, %s maths\n", frames, seed, pool.size(), hz, continuous ? " swept" : "",
+           mathName());
+    if (world.scrolling())
+        printf("arena %d x %d screens, %d x %d sectors, %lu active, %lu rocks parked\n", world.across, world.down,
+               world.sectors.cols, world.sectors.rows, (unsigned long) world.sectors.window.size(),
+               (unsigned long) world.sectors.parkedCount());
+    printf("score %u level %u lives %d entities %lu\n", world.score, world.level, world.lives,
+           (unsigned long) world.store.size());
+    printf("hash %016llx\n", (unsigned long long) world.hash());
+    printf("%.3f s, %.0f ticks/s\n", elapsed.count(), frames / elapsed.count());
+    printf("%lu heap allocations, %.4f per tick\n", allocs, (double) allocs / frames);
+
+    FrameStats st;
+    if (profileStats(st))
+        printf("last %d ticks: p50 %.4f ms p95 %.4f ms p99 %.4f ms worst %.4f ms\n", st.frames, st.p50, st.p95,
+               st.p99, st.worst);
+    if (tracePath) {
+        if (profileTrace(tracePath)) printf("trace written to %s\n", tracePath);
+        else printf("no trace, profiling is compiled out of this build\n");
+    }
+
+    printf("pool       capacity  peak  misses\n");
+    for (int k = 0; k < KIND_COUNT; k++) {
+        const PoolStats &st = world.store.stats[k];
+        printf("%-10s %8lu %5lu %7lu\n", kindNames[k], (unsigned long) st.capacity, (unsigned long) st.peak,
+               (unsigned long) st.misses);
+    }
+    printf("effects ring of %lu, %lu live at the end\n", (unsigned long) Effects::CAPACITY,
+           (unsigned long) world.effects.live());
+    printf("commands per tick:");
+    for (int t = 0; t < CMD_COUNT; t++)
+        printf(" %s %.4f", commandNames[t], (double) world.commands.totals[t] / frames);
+    printf("\n");
+    return 0;
+}
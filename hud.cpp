@@ -0,0 +1,78 @@
+#include "hud.h"
+
+#include <string>
+
+using namespace sf;
+
+Hud::Hud(const Font &font, const Texture &lifeIcon) : score(0), level(1), lives(3), dirty(true) {
+    scoretext.setFont(font); // text item that displays the current score
+    scoretext.setString("SCORE 0");
+    scoretext.setFillColor(Color::Cyan);
+    scoretext.setCharacterSize(64);
+    scoretext.setPosition(10.f, 10.f);
+
+    leveltext.setFont(font); // text item that displays the current level
+    leveltext.setString("LEVEL 1");
+    leveltext.setFillColor(Color::Yellow);
+    leveltext.setCharacterSize(50);
+    leveltext.setPosition(960.f, 700.f);
+
+    gameover.setFont(font); // gameover displayed when lives = 0
+    gameover.setString("GAME OVER");
+    gameover.setFillColor(Color::Red);
+    gameover.setCharacterSize(110);
+    gameover.setPosition(275.f, 310.f);
+
+    const float x[3] = {1125.f, 1050.f, 975.f}; // right to left, the leftmost goes first
+    for (int i = 0; i < 3; i++) {
+        life[i].setTexture(lifeIcon);
+        life[i].setPosition(Vector2f(x[i], 10.f));
+    }
+}
+
+bool Hud::create(unsigned int width, unsigned int height) {
+    if (!cache.create(width, height)) return false;
+    composite.setTexture(cache.getTexture(), true);
+    dirty = true;
+    return true;
+}
+
+void Hud::setScore(unsigned int s) {
+    if (s == score) return;
+    score = s;
+    scoretext.setString("SCORE " + std::to_string(score));
+    dirty = true;
+}
+
+void Hud::setLevel(unsigned int l) {
+    if (l == level) return;
+    level = l;
+    leveltext.setString("LEVEL " + std::to_string(level));
+    dirty = true;
+}
+
+void Hud::setLives(int l) {
+    if (l == lives || (l <= 0 && lives <= 0)) return; // nothing more to take away after game over
+    lives = l;
+    dirty = true;
+}
+
+void Hud::redraw() {
+    cache.clear(Color::Transparent);
+    if (lives > 0) {
+        cache.draw(scoretext); // draw stuff necessary for the game
+        cache.draw(leveltext);
+        for (int i = 0; i < 3 && i < lives; i++)
+            cache.draw(life[i]);
+    } else {
+        cache.draw(gameover);
+        cache.draw(scoretext);
+    }
+    cache.display();
+    dirty = false;
+}
+
+void Hud::draw(RenderTarget &app) {
+    if (dirty) redraw();
+    app.draw(composite);
+}
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - HUD
+// DESCRIPTION: Score, level and life icons, kept drawn in an off-screen texture. The texts are only rebuilt
+// when the number they show changes, and the texture only redrawn when one of them did, so a normal frame
+// puts the whole HUD on screen with a single draw and nothing else.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_HUD_H
+#define ASTEROIDS_HUD_H
+
+#include <SFML/Graphics.hpp>
+
+class Hud {
+public:
+    Hud(const sf::Font &font, const sf::Texture &lifeIcon); // font for every text, one icon per life
+
+    bool create(unsigned int width, unsigned int height); // the off-screen texture, same size as the window
+
+    // these only mark the HUD dirty when the value is actually different
+    void setScore(unsigned int score);
+    void setLevel(unsigned int level);
+    void setLives(int lives); // 0 or less shows game over
+
+    void draw(sf::RenderTarget &app); // one draw call, plus the redraw of the texture after a change
+
+private:
+    sf::Text scoretext, leveltext, gameover;
+    sf::Sprite life[3];
+
+    sf::RenderTexture cache;
+    sf::Sprite composite; // cache on screen
+
+    unsigned int score, level;
+    int lives;
+    bool dirty;
+
+    void redraw();
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "integrate.h"
+#include "fixed.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define ASTEROIDS_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ASTEROIDS_SSE2 1
+#endif
+
+void integrateScalar(float *x, float *y, const float *dx, const float *dy, size_t n, float dt) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] += dx[i] * dt;
+        y[i] += dy[i] * dt;
+    }
+}
+
+void integrateFixed(float *x, float *y, const float *dx, const float *dy, size_t n, float dt) {
+    int32_t t = toFix(dt); // 2 down to 1/4, on the grid too
+    for (size_t i = 0; i < n; i++) {
+        x[i] = fromFix(toFix(x[i]) + toFix(dx[i]) * t / FIX_ONE);
+        y[i] = fromFix(toFix(y[i]) + toFix(dy[i]) * t / FIX_ONE);
+    }
+}
+
+void wrapScalar(float *x, float *y, size_t n, float w, float h) {
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] > w) x[i] = 0; // wrap around to other side of screen
+        if (x[i] < 0) x[i] = w;
+        if (y[i] > h) y[i] = 0;
+        if (y[i] < 0) y[i] = h;
+    }
+}
+
+void cullScalar(const float *x, const float *y, unsigned char *life, size_t n, float w, float h) {
+    for (size_t i = 0; i < n; i++)
+        if (x[i] > w || x[i] < 0 || y[i] > h || y[i] < 0) life[i] = 0; // disappear if falls off screen
+}
+
+#if ASTEROIDS_AVX
+
+const char *simdName() { return "avx"; }
+
+void integrate(float *x, float *y, const float *dx, const float *dy, size_t n, float dt) {
+    __m256 t = _mm256_set1_ps(dt);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(dx + i), t)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(dy + i), t)));
+    }
+    integrateScalar(x + i, y + i, dx + i, dy + i, n - i, dt);
+}
+
+static inline __m256 wrap8(__m256 v, __m256 edge) {
+    __m256 zero = _mm256_setzero_ps();
+    v = _mm256_andnot_ps(_mm256_cmp_ps(v, edge, _CMP_GT_OQ), v); // past the far edge -> 0
+    return _mm256_blendv_ps(v, edge, _mm256_cmp_ps(v, zero, _CMP_LT_OQ)); // before 0 -> far edge
+}
+
+void wrap(float *x, float *y, size_t n, float w, float h) {
+    __m256 W8 = _mm256_set1_ps(w), H8 = _mm256_set1_ps(h);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, wrap8(_mm256_loadu_ps(x + i), W8));
+        _mm256_storeu_ps(y + i, wrap8(_mm256_loadu_ps(y + i), H8));
+    }
+    wrapScalar(x + i, y + i, n - i, w, h);
+}
+
+void cull(const float *x, const float *y, unsigned char *life, size_t n, float w, float h) {
+    __m256 W8 = _mm256_set1_ps(w), H8 = _mm256_set1_ps(h), zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i);
+        __m256 out = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(vx, W8, _CMP_GT_OQ), _mm256_cmp_ps(vx, zero, _CMP_LT_OQ)),
+                                  _mm256_or_ps(_mm256_cmp_ps(vy, H8, _CMP_GT_OQ), _mm256_cmp_ps(vy, zero, _CMP_LT_OQ)));
+        int bits = _mm256_movemask_ps(out);
+        if (bits)
+            for (int j = 0; j < 8; j++)
+                if (bits & (1 << j)) life[i + j] = 0;
+    }
+    cullScalar(x + i, y + i, life + i, n - i, w, h);
+}
+
+#elif ASTEROIDS_SSE2
+
+const char *simdName() { return "sse2"; }
+
+void integrate(float *x, float *y, const float *dx, const float *dy, size_t n, float dt) {
+    __m128 t = _mm_set1_ps(dt);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(dx + i), t)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(dy + i), t)));
+    }
+    integrateScalar(x + i, y + i, dx + i, dy + i, n - i, dt);
+}
+
+static inline __m128 wrap4(__m128 v, __m128 edge) {
+    v = _mm_andnot_ps(_mm_cmpgt_ps(v, edge), v); // past the far edge -> 0
+    __m128 under = _mm_cmplt_ps(v, _mm_setzero_ps()); // before 0 -> far edge
+    return _mm_or_ps(_mm_andnot_ps(under, v), _mm_and_ps(under, edge));
+}
+
+void wrap(float *x, float *y, size_t n, float w, float h) {
+    __m128 W4 = _mm_set1_ps(w), H4 = _mm_set1_ps(h);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, wrap4(_mm_loadu_ps(x + i), W4));
+        _mm_storeu_ps(y + i, wrap4(_mm_loadu_ps(y + i), H4));
+    }
+    wrapScalar(x + i, y + i, n - i, w, h);
+}
+
+void cull(const float *x, const float *y, unsigned char *life, size_t n, float w, float h) {
+    __m128 W4 = _mm_set1_ps(w), H4 = _mm_set1_ps(h), zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i);
+        __m128 out = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(vx, W4), _mm_cmplt_ps(vx, zero)),
+                               _mm_or_ps(_mm_cmpgt_ps(vy, H4), _mm_cmplt_ps(vy, zero)));
+        int bits = _mm_movemask_ps(out);
+        if (bits)
+            for (int j = 0; j < 4; j++)
+                if (bits & (1 << j)) life[i + j] = 0;
+    }
+    cullScalar(x + i, y + i, life + i, n - i, w, h);
+}
+
+#else
+
+const char *simdName() { return "scalar"; }
+
+void integrate(float *x, float *y, const float *dx, const float *dy, size_t n, float dt) { integrateScalar(x, y, dx, dy, n, dt); }
+void wrap(float *x, float *y, size_t n, float w, float h) { wrapScalar(x, y, n, w, h); }
+void cull(const float *x, const float *y, unsigned char *life, size_t n, float w, float h) { cullScalar(x, y, life, n, w, h); }
+
+#endif
@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - INTEGRATION KERNELS
+// DESCRIPTION: The per-frame movement maths over whole arrays at once: position += velocity, wrapping around
+// the screen edges, and flagging whatever has flown off screen. Uses AVX when built with it, SSE2 on any
+// x86-64, and plain loops everywhere else. Every path gives bit-identical results.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_INTEGRATE_H
+#define ASTEROIDS_INTEGRATE_H
+
+#include <cstddef>
+
+void integrate(float *x, float *y, const float *dx, const float *dy, size_t n, float dt); // x += dx * dt, y += dy * dt
+void wrap(float *x, float *y, size_t n, float w, float h); // past one edge comes back at the other
+void cull(const float *x, const float *y, unsigned char *life, size_t n, float w, float h); // life = 0 when off screen
+
+// the same three without SIMD, for the fallback and for the benchmark to compare against
+void integrateScalar(float *x, float *y, const float *dx, const float *dy, size_t n, float dt);
+void wrapScalar(float *x, float *y, size_t n, float w, float h);
+void cullScalar(const float *x, const float *y, unsigned char *life, size_t n, float w, float h);
+
+// the ASTEROIDS_FIXED build's movement: x, y, dx, dy all on the 1/256 pixel grid (see fixed.h), each step worked
+// out in integers
+void integrateFixed(float *x, float *y, const float *dx, const float *dy, size_t n, float dt);
+
+const char *simdName(); // which instruction set the kernels were built for
+
+#endif
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - INTEGRATION BENCHMARK
+// DESCRIPTION: Times one frame of movement for 1k, 10k and 100k entities (three rocks to every bullet) three
+// ways: the old path of one new-ed object per entity in a std::list with a virtual update(), plain loops over
+// the entity arrays, and the SIMD kernels from integrate.cpp. The last column is the fixed point build's
+// movement (integrateFixed) with the same wrap and cull.
+// USAGE: integrate_bench
+///////////////////////////////////////////////////
+
+#include "integrate.h"
+#include "world.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+class Object { // the way entities used to be stored and updated
+public:
+    float x, y, dx, dy, angle;
+    bool life;
+
+    Object() : x(0), y(0), dx(0), dy(0), angle(0), life(true) {}
+    virtual void update() {}
+    virtual ~Object() {}
+};
+
+class Rock : public Object {
+public:
+    void update() {
+        x += dx;
+        y += dy;
+
+        if (x > W) x = 0;
+        if (x < 0) x = W;
+        if (y > H) y = 0;
+        if (y < 0) y = H;
+    }
+};
+
+class Shot : public Object {
+public:
+    void update() {
+        dx = cos(angle * DEGTORAD) * 6;
+        dy = sin(angle * DEGTORAD) * 6;
+        x += dx;
+        y += dy;
+
+        if (x > W || x < 0 || y > H || y < 0) life = 0;
+    }
+};
+
+struct Arrays { // one kind's worth of entity arrays
+    std::vector<float> x, y, dx, dy;
+    std::vector<unsigned char> life;
+
+    void push(float X, float Y, float DX, float DY) {
+        x.push_back(X);
+        y.push_back(Y);
+        dx.push_back(DX);
+        dy.push_back(DY);
+        life.push_back(1);
+    }
+};
+
+template<class F>
+double nsPerEntity(size_t n, F frame) { // runs frames until a quarter of a second has gone by
+    frame(); // warm up
+    long frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    do {
+        frame();
+        frames++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.25);
+    return elapsed.count() * 1e9 / (frames * (double) n);
+}
+
+int main() {
+    printf("kernels built for %s\n", simdName());
+    printf("%8s %12s %12s %12s %12s\n", "entities", "virtual ns", "scalar ns", "simd ns", "fixed ns");
+
+    size_t sizes[] = {1000, 10000, 100000};
+    for (size_t n:sizes) {
+        srand(1);
+        std::list<Object *> objects;
+        Arrays rocks, shots;
+        for (size_t i = 0; i < n; i++) {
+            float x = rand() % W, y = rand() % H;
+            if (i % 4 == 3) {
+                Shot *s = new Shot();
+                s->x = x;
+                s->y = y;
+                s->angle = rand() % 360;
+                objects.push_back(s);
+                shots.push(x, y, cos(s->angle * DEGTORAD) * 6, sin(s->angle * DEGTORAD) * 6);
+            } else {
+                Rock *r = new Rock();
+                r->x = x;
+                r->y = y;
+                r->dx = rand() % 8 - 4;
+                r->dy = rand() % 8 - 4;
+                objects.push_back(r);
+                rocks.push(x, y, r->dx, r->dy);
+            }
+        }
+        Arrays rocks2 = rocks, shots2 = shots, rocks3 = rocks, shots3 = shots;
+
+        double virt = nsPerEntity(n, [&objects]() {
+            for (auto o:objects) o->update();
+        });
+        double scalar = nsPerEntity(n, [&rocks, &shots]() {
+            integrateScalar(rocks.x.data(), rocks.y.data(), rocks.dx.data(), rocks.dy.data(), rocks.x.size(), 1);
+            wrapScalar(rocks.x.data(), rocks.y.data(), rocks.x.size(), W, H);
+            integrateScalar(shots.x.data(), shots.y.data(), shots.dx.data(), shots.dy.data(), shots.x.size(), 1);
+            cullScalar(shots.x.data(), shots.y.data(), shots.life.data(), shots.x.size(), W, H);
+        });
+        double simd = nsPerEntity(n, [&rocks2, &shots2]() {
+            integrate(rocks2.x.data(), rocks2.y.data(), rocks2.dx.data(), rocks2.dy.data(), rocks2.x.size(), 1);
+            wrap(rocks2.x.data(), rocks2.y.data(), rocks2.x.size(), W, H);
+            integrate(shots2.x.data(), shots2.y.data(), shots2.dx.data(), shots2.dy.data(), shots2.x.size(), 1);
+            cull(shots2.x.data(), shots2.y.data(), shots2.life.data(), shots2.x.size(), W, H);
+        });
+
+        double fixed = nsPerEntity(n, [&rocks3, &shots3]() {
+            integrateFixed(rocks3.x.data(), rocks3.y.data(), rocks3.dx.data(), rocks3.dy.data(), rocks3.x.size(), 1);
+            wrap(rocks3.x.data(), rocks3.y.data(), rocks3.x.size(), W, H);
+            integrateFixed(shots3.x.data(), shots3.y.data(), shots3.dx.data(), shots3.dy.data(), shots3.x.size(), 1);
+            cull(shots3.x.data(), shots3.y.data(), shots3.life.data(), shots3.x.size(), W, H);
+        });
+
+        printf("%8lu %12.3f %12.3f %12.3f %12.3f\n", (unsigned long) n, virt, scalar, simd, fixed);
+
+        for (auto o:objects) delete o;
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "jobs.h"
+
+#include <algorithm>
+
+JobPool::JobPool(int threads) : workers(std::max(threads, 1)), queues(workers), generation(0), quit(false),
+                                job(0), jobN(0), jobChunk(1), remaining(0) {
+    for (int i = 1; i < workers; i++)
+        this->threads.push_back(std::thread(&JobPool::worker, this, i));
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto &t:threads)
+        t.join();
+}
+
+void JobPool::parallelFor(size_t n, size_t chunkSize, const Job &f) {
+    size_t count = chunks(n, chunkSize);
+    if (count == 0) return;
+
+    if (workers == 1 || count == 1) { // nothing to share, skip the queues
+        for (size_t c = 0; c < count; c++)
+            f(c, c * chunkSize, std::min(n, (c + 1) * chunkSize));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        job = &f;
+        jobN = n;
+        jobChunk = chunkSize;
+        remaining = count;
+        for (size_t c = 0; c < count; c++) { // deal the chunks out like cards
+            Queue &q = queues[c % workers];
+            std::lock_guard<std::mutex> ql(q.m);
+            q.chunks.push_back(c);
+        }
+        generation++;
+    }
+    wake.notify_all();
+
+    while (runOne(0)) {}
+
+    std::unique_lock<std::mutex> lock(m); // the last few chunks may still be running on other threads
+    done.wait(lock, [this] { return remaining == 0; });
+    job = 0;
+}
+
+bool JobPool::runOne(int id) {
+    size_t c = 0;
+    bool found = false;
+
+    { // our own queue first, newest chunk
+        Queue &q = queues[id];
+        std::lock_guard<std::mutex> ql(q.m);
+        if (!q.chunks.empty()) {
+            c = q.chunks.back();
+            q.chunks.pop_back();
+            found = true;
+        }
+    }
+    for (int i = 1; i < workers && !found; i++) { // then steal the oldest chunk from whoever has one
+        Queue &q = queues[(id + i) % workers];
+        std::lock_guard<std::mutex> ql(q.m);
+        if (!q.chunks.empty()) {
+            c = q.chunks.front();
+            q.chunks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    (*job)(c, c * jobChunk, std::min(jobN, (c + 1) * jobChunk));
+
+    if (--remaining == 0) {
+        std::lock_guard<std::mutex> lock(m);
+        done.notify_all();
+    }
+    return true;
+}
+
+void JobPool::worker(int id) {
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            wake.wait(lock, [this, seen] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        while (runOne(id)) {}
+    }
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - JOB POOL
+// DESCRIPTION: A fixed set of worker threads for splitting the simulation step across cores. A parallel loop
+// is cut into chunks that are dealt out to the workers' own queues. A worker takes from the back of its own
+// queue and, once that is empty, steals from the front of the others'. The thread that starts the loop works
+// as worker 0 and waits until every chunk is done.
+// Chunks are cut the same way whatever the thread count, so anything a chunk writes to its own output slot
+// comes out the same with 1 thread or 16.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_JOBS_H
+#define ASTEROIDS_JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobPool {
+public:
+    typedef std::function<void(size_t chunk, size_t begin, size_t end)> Job;
+
+    explicit JobPool(int threads); // total workers, counting the thread that calls parallelFor
+    ~JobPool();
+
+    int size() const { return workers; }
+
+    // runs job over [0, n) in pieces of at most chunkSize, returns once all of them are done
+    void parallelFor(size_t n, size_t chunkSize, const Job &job);
+
+    static size_t chunks(size_t n, size_t chunkSize) { return (n + chunkSize - 1) / chunkSize; }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<size_t> chunks;
+    };
+
+    int workers;
+    std::vector<std::thread> threads;
+    std::vector<Queue> queues; // one per worker
+
+    std::mutex m;
+    std::condition_variable wake, done;
+    unsigned long generation; // bumped for every parallelFor so sleeping workers know there is work
+    bool quit;
+
+    const Job *job; // the loop being run right now
+    size_t jobN, jobChunk;
+    std::atomic<size_t> remaining; // chunks not finished yet
+
+    JobPool(const JobPool &);
+    JobPool &operator=(const JobPool &);
+
+    void worker(int id);
+    bool runOne(int id); // does one chunk from our queue or someone else's, false when there are none left
+};
+
+#endif
@@ -0,0 +1,35 @@
+#include "lossy_link.h"
+
+LossyLink::LossyLink(uint64_t seed, size_t capacity) :
+        loss(0), latency(0), jitter(0), sent(0), dropped(0), ring(capacity), rng(seed) {
+    for (auto &p:ring)
+        p.used = false;
+}
+
+void LossyLink::send(const uint8_t *data, size_t n, unsigned long now) {
+    sent++;
+    if (loss > 0 && rng.next() % 10000 < loss * 10000) {
+        dropped++;
+        return;
+    }
+
+    for (auto &p:ring) {
+        if (p.used) continue;
+        p.data.assign(data, data + n); // the buffer grows to the biggest packet once, then stays
+        p.due = now + latency + (jitter ? rng.next() % (jitter + 1) : 0);
+        p.used = true;
+        return;
+    }
+    dropped++; // more in flight than the ring holds
+}
+
+bool LossyLink::receive(std::vector<uint8_t> &out, unsigned long now) {
+    Packet *next = 0;
+    for (auto &p:ring)
+        if (p.used && p.due <= now && (!next || p.due < next->due)) next = &p;
+    if (!next) return false;
+
+    out.assign(next->data.begin(), next->data.end());
+    next->used = false;
+    return true;
+}
@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - LOSSY LINK
+// DESCRIPTION: Pretends to be a bad network for testing on one machine. Packets put in come back out after
+// the latency plus up to jitter milliseconds, so they can arrive out of order, and a share of them never come
+// out at all. The packets sit in a fixed ring whose buffers are reused, a full ring drops the packet.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_LOSSY_LINK_H
+#define ASTEROIDS_LOSSY_LINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rng.h"
+
+class LossyLink {
+public:
+    float loss; // 0..1, share of packets dropped
+    unsigned int latency, jitter; // milliseconds
+
+    explicit LossyLink(uint64_t seed = 1, size_t capacity = 256);
+
+    void send(const uint8_t *data, size_t n, unsigned long now); // now in milliseconds, any clock
+    bool receive(std::vector<uint8_t> &out, unsigned long now); // the packet due soonest, once its time has come
+
+    unsigned long sent, dropped;
+
+private:
+    struct Packet {
+        std::vector<uint8_t> data;
+        unsigned long due;
+        bool used;
+    };
+    std::vector<Packet> ring;
+    Rng rng;
+};
+
+#endif
@@ -9,8 +9,19 @@
 #include <SFML/Window.hpp>
 #include <SFML/Audio.hpp>
 #include <time.h>
-#include <list>
-#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "assets.h"
+#include "hud.h"
+#include "mixer.h"
+#include "net.h"
+#include "profile.h"
+#include "render.h"
+#include "replay.h"
+#include "world.h"
 
 //////////////CITATIONS///////////////
 // UFO IMAGE: "UFO" BY AHA-SOFT (ICONARCHIVE.COM) - FREE FOR PERSONAL USE
@@ -24,237 +35,130 @@
 
 using namespace sf;
 
-const int W = 1200; // height and width of app
-const int H = 800;
-
-float DEGTORAD = 0.017453f; // conversion to radians
-
-class Animation {
-public:
-
-    float Frame, speed;
-    Sprite sprite;
-    std::vector<IntRect> frames;
-
-    Animation() {}
-
-    Animation(Texture &t, int x, int y, int w, int h, int count, float Speed) {
-        Frame = 0; // number of frames
-        speed = Speed; // speed at which the frames of the animation are displayed
-
-        for (int i = 0; i < count; i++) // for each frame
-            frames.push_back(IntRect(x + i * w, y, w, h)); //set dimensions
-
-        sprite.setTexture(t); // graphics set up
-        sprite.setOrigin(w / 2, h / 2);
-        sprite.setTextureRect(frames[0]);
-    }
-
-
-    void update() {
-        Frame += speed; // changes frame for each speed increment
-        int n = frames.size();
-        if (Frame >= n) Frame -= n;
-        if (n > 0) sprite.setTextureRect(frames[int(Frame)]); // creates moving animation effect
-    }
-
-    bool isEnd() {
-        return Frame + speed >= frames.size(); // is end of animation
-    }
-
-};
-
-
-class Entity {
-public:
-    float x, y, dx, dy, R, angle; // attributes of an entity (ie. asteroid, spaceship, ufo, bullet)
-    bool life; // whether or not the entity should be displayed
-    std::string name;
-    Animation anim; // its animation if applicable
-
-    Entity() {
-        life = 1;
-    }
-
-    void settings(Animation &a, int X, int Y, float Angle = 0, int radius = 1) { // function sort of like a constructor giving entity needed values
-        anim = a;
-        x = X;
-        y = Y;
-        angle = Angle;
-        R = radius;
-    }
-
-    virtual void update() {}; // polymorphic function that is used in derived classes because each has its own behavior
-
-    void draw(RenderWindow &app) { // displays an entity or sprite or text (etc.) to screen
-        anim.sprite.setPosition(x, y);
-        anim.sprite.setRotation(angle + 90);
-        app.draw(anim.sprite);
-
-        CircleShape circle(R);
-        circle.setFillColor(Color(255, 0, 0, 170));
-        circle.setPosition(x, y);
-        circle.setOrigin(R, R);
-        //app.draw(circle);
-    }
-
-    virtual ~Entity() {}; // polymorphic destructor to kill entities based on what they are
-};
-
-///////////UFO class documentation///////////
-class ufo : public Entity {
-    static int count; // updates at run-time for numer of UFOs alive
-public:
-    ufo() {
-        dx = 2 + rand() % 4; // change in position
-        dy = 0;
-        count++;
-        angle = 0;
-        name = "ufo";
-    }
-
-    ~ufo() //destructor
-    {
-        count--;
-    }
-
-    void update() {
-        x += dx;
-        y += dy;
-    }
-
-    static unsigned int getCount() // gets count to keep at no more than one
-    {
-        return count;
-    }
-};
-
-int ufo::count = 0;
-
-class asteroid : public Entity {
-    static int count; // updates at run-time for current asteroid count
-public:
-    asteroid() {
-        dx = rand() % 8 - 4; // change in position
-        dy = rand() % 8 - 4;
-        count++;
-        name = "asteroid";
-    }
-
-    ~asteroid() //destructor
-    {
-        count--;
-    }
-
-    void update() {
-        x += dx; // change position by dx and dy
-        y += dy;
-
-        if (x > W) x = 0; // wrap around to other side of screen
-        if (x < 0) x = W;
-        if (y > H) y = 0;
-        if (y < 0) y = H;
-    }
+static bool readFile(const char *path, std::vector<uint8_t> &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(n > 0 ? n : 0);
+    bool ok = n > 0 && fread(out.data(), 1, n, f) == (size_t) n;
+    fclose(f);
+    return ok;
+}
 
-    static unsigned int getCount()
-    {
-        return count;
+int main(int argc, char **argv) {
+    bool stats = false; // --stats prints draw calls per frame once a second
+    int hz = 60; // --hz 120 or 240 ticks the game more often, the speeds stay the same
+    const char *recordPath = 0, *replayPath = 0; // --record file saves the game, --replay file watches one
+    float speed = 1; // --speed 4 plays a replay 4 times faster
+    bool continuous = false; // --ccd, swept collision
+    const char *tracePath = 0; // --trace file saves a Chrome trace of the last few seconds on exit
+    unsigned short serverPort = 0; // --server port runs the game with no window for clients to play
+    const char *host = 0; // --connect host port plays the game a server is running
+    unsigned short port = 0;
+    LinkSettings link; // --lag ms, --jitter ms and --loss percent make what this end sends arrive late or not at all
+    const char *loadPath = 0; // --load file starts from a save, F5 saves to quicksave.sav and F9 goes back to it
+    int across = 1, down = 1; // --arena n plays in an arena n screens across and down, the view follows the ship
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stats") stats = true;
+        if (arg == "--hz" && i + 1 < argc) hz = atoi(argv[++i]);
+        if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        if (arg == "--speed" && i + 1 < argc) speed = atof(argv[++i]);
+        if (arg == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        if (arg == "--ccd") continuous = true;
+        if (arg == "--server" && i + 1 < argc) serverPort = atoi(argv[++i]);
+        if (arg == "--connect" && i + 2 < argc) {
+            host = argv[++i];
+            port = atoi(argv[++i]);
+        }
+        if (arg == "--lag" && i + 1 < argc) link.latency = atoi(argv[++i]);
+        if (arg == "--jitter" && i + 1 < argc) link.jitter = atoi(argv[++i]);
+        if (arg == "--loss" && i + 1 < argc) link.loss = atof(argv[++i]) / 100;
+        if (arg == "--load" && i + 1 < argc) loadPath = argv[++i];
+        if (arg == "--arena" && i + 1 < argc) across = down = std::max(1, std::min(100, atoi(argv[++i])));
     }
-
-};
-
-int asteroid::count = 0;
-
-class bullet : public Entity {
-public:
-    bullet() {
-        name = "bullet";
+    if (!supportedHz(hz)) hz = 60;
+    if (speed <= 0) speed = 1;
+
+    unsigned int seed = time(0);
+    ReplayReader playback;
+    if (replayPath) {
+        if (!playback.open(replayPath)) {
+            fprintf(stderr, "can't read replay %s\n", replayPath);
+            return EXIT_FAILURE;
+        }
+        seed = playback.seed; // same start as the recording
+        hz = playback.hz;
+        continuous = playback.continuous;
+        across = playback.across;
+        down = playback.down;
+    } else {
+        speed = 1;
     }
-
-    void update() {
-        dx = cos(angle * DEGTORAD) * 6; //change in position
-        dy = sin(angle * DEGTORAD) * 6;
-        // angle+=rand()%6-3;
-        x += dx;
-        y += dy;
-
-        if (x > W || x < 0 || y > H || y < 0) life = 0; // disappear if falls off screen
+    if ((serverPort || host) && across * down > 1) { // snapshots and inputs are for the one screen game
+        fprintf(stderr, "--arena isn't played over the network, the game is one screen\n");
+        across = down = 1;
     }
+    if (serverPort)
+        return runServer(serverPort, link, seed, hz, continuous);
 
-};
-
-
-class player : public Entity // player = the spaceship
-{
-public:
-    bool thrust; // whether or not forward key is pressed -- trust = speeding up/down effect
-
-    player() {
-        name = "player";
+    NetClient net(link); // with --connect the world here is never stepped, what is drawn comes from the server
+    if (host && !net.connect(host, port)) {
+        fprintf(stderr, "can't reach %s\n", host);
+        return EXIT_FAILURE;
     }
-
-    void update() {
-        if (thrust) { // trust is for the effect of making the ship speed up and slow down depending on if the up key is being pressed
-            dx += cos(angle * DEGTORAD) * 0.2;
-            dy += sin(angle * DEGTORAD) * 0.2;
-        } else {
-            dx *= 0.99;
-            dy *= 0.99;
+    World world(seed, hz, across, down);
+    world.continuous = continuous;
+
+    std::vector<uint8_t> quicksave; // a replay can't jump about, so no saves or loads while recording or watching one
+    bool canLoad = !recordPath && !replayPath && !host;
+    if (loadPath) {
+        if (!canLoad || !readFile(loadPath, quicksave) || !world.restore(quicksave.data(), quicksave.size())) {
+            fprintf(stderr, "can't load %s\n", loadPath);
+            return EXIT_FAILURE;
         }
-
-        int maxSpeed = 15;
-        float speed = sqrt(dx * dx + dy * dy);
-        if (speed > maxSpeed) {
-            dx *= maxSpeed / speed;
-            dy *= maxSpeed / speed;
-        }
-
-        x += dx; // updating positon by dy and dx
-        y += dy;
-
-        if (x > W) x = 0; // wrap around screen
-        if (x < 0) x = W;
-        if (y > H) y = 0;
-        if (y < 0) y = H;
     }
 
-};
-
+    ReplayWriter recording;
+    if (recordPath && !recording.open(recordPath, world, seed)) {
+        fprintf(stderr, "can't write replay %s\n", recordPath);
+        return EXIT_FAILURE;
+    }
+    if (replayPath) playback.check(world);
 
-bool isCollide(Entity *a, Entity *b) {
-    return (b->x - a->x) * (b->x - a->x) +
-           (b->y - a->y) * (b->y - a->y) <
-           (a->R + b->R) * (a->R + b->R);
-}
+    RenderWindow app(VideoMode(W, H), "Asteroids!"); // title of window
+    app.setVerticalSyncEnabled(true); // draws as often as the screen refreshes, the game ticks on its own clock below
+    app.clear(); // the window is up straight away while everything loads
+    app.display();
+
+    uint64_t loadStart = profileNow(); // everything up to music.play() is loading
+    Assets assets; // pictures and sounds decode on background threads, each path once
+    assets.openPack("assets.pack"); // pre-decoded by the asset_pack build step, the files are used if it's missing
+    assets.request("images/background.jpg"); // ask for everything up front so it all decodes at the same time
+    assets.request("images/lifeicon.png");
+    assets.request("sounds/robotglitch.ogg");
+    assets.request("sounds/ufosound.ogg");
+
+    Renderer renderer; // the entities' pictures all go into one atlas
+    View camera(FloatRect(0, 0, W, H)); // the part of the arena on screen, all of it unless the world scrolls
+    if (!renderer.atlas.build(assets))
+        return EXIT_FAILURE;
+    int drawCalls = 0, frames = 0; // for --stats
 
+    Texture *t2 = assets.texture("images/background.jpg"); //loading pictures from images folder into textures to be used for sprites
+    Texture *t9 = assets.texture("images/lifeicon.png"); // one texture for all three life icons
+    Texture *t12 = 0; // final level background, only loaded once the game gets to level 4
+    if (!t2 || !t9)
+        return EXIT_FAILURE;
 
-int main() {
-    srand(time(0));
-
-    RenderWindow app(VideoMode(W, H), "Asteroids!"); // title of window
-    app.setFramerateLimit(60); // game runs at 60 frames per second
-
-    Texture t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12;
-    t1.loadFromFile("images/spaceship.png"); //loading pictures from images folder into textures to be used for sprites and animations
-    t2.loadFromFile("images/background.jpg");
-    t3.loadFromFile("images/explosions/type_C.png");
-    t4.loadFromFile("images/rock.png");
-    t5.loadFromFile("images/fire_red.png");
-    t6.loadFromFile("images/rock_small.png");
-    t7.loadFromFile("images/explosions/type_B.png");
-    t8.loadFromFile("images/UFO.png");
-    t9.loadFromFile("images/lifeicon.png");
-    t10.loadFromFile("images/lifeicon.png");
-    t11.loadFromFile("images/lifeicon.png");
-    t12.loadFromFile("images/finallevelback.jpg");
-
-    t1.setSmooth(true); // makes pictures smooth
-    t2.setSmooth(true);
-    t8.setSmooth(true);
+    t2->setSmooth(true); // makes pictures smooth
 
     sf::Vector2u TextureSize; // scaling new background image to fit game screen
     sf::Vector2u WindowSize;
-    TextureSize = t2.getSize();
+    TextureSize = t2->getSize();
     WindowSize = app.getSize();
     float ScaleX = (float) WindowSize.x / TextureSize.x;
     float ScaleY = (float) WindowSize.y / TextureSize.y;
@@ -268,350 +172,235 @@ int main() {
     bool loop = 1;
     music.setLoop(loop); // loops music
 
-    sf::SoundBuffer astbuff;
-    if (!astbuff.loadFromFile("sounds/robotglitch.ogg")) { // soundbuffer for asteroid explosion
+    sf::SoundBuffer *astbuff = assets.sound("sounds/robotglitch.ogg");
+    if (!astbuff) { // soundbuffer for asteroid explosion
         return EXIT_FAILURE;
     }
-    sf::Sound astsound;
-    astsound.setBuffer(astbuff); // asteroid explosion noise
 
-    sf::SoundBuffer ufobuff;
-    if (!ufobuff.loadFromFile("sounds/ufosound.ogg")) // ufo sound and buffer
+    sf::SoundBuffer *ufobuff = assets.sound("sounds/ufosound.ogg");
+    if (!ufobuff) // ufo sound and buffer
     {
         return EXIT_FAILURE;
     }
-    sf::Sound ufosound;
-    ufosound.setBuffer(ufobuff);
-
-    Sprite background(t2); // sets loaded picture file as background sprite
-    background.setScale(ScaleX,ScaleY); // set scale of image
-    Sprite finalback(t12);
 
-    Sprite life1(t9); //life icon images
-    Sprite life2(t10);
-    Sprite life3(t11);
-    life1.setPosition(sf::Vector2f(1125.f, 10.f)); //set position of life icons
-    life2.setPosition(sf::Vector2f(1050.f, 10.f));
-    life3.setPosition(sf::Vector2f(975.f, 10.f));
+    Mixer mixer; // every sound effect plays through its voices
 
-
-    Animation sExplosion(t3, 0, 0, 256, 256, 48, 0.5); // creates animation objects for entities and sets texture, speed, etc.
-    Animation sRock(t4, 0, 0, 64, 64, 16, 0.2);
-    Animation sRock_small(t6, 0, 0, 64, 64, 16, 0.2);
-    Animation sBullet(t5, 0, 0, 32, 64, 16, 0.8);
-    Animation sPlayer(t1, 40, 0, 40, 40, 1, 0);
-    Animation sPlayer_go(t1, 40, 40, 40, 40, 1, 0);
-    Animation sExplosion_ship(t7, 0, 0, 192, 192, 64, 0.5);
-    Animation sUFO(t8, 0, 0, 70, 70, 1, 0.1); // ufo animation
+    Sprite background(*t2); // sets loaded picture file as background sprite
+    background.setScale(ScaleX,ScaleY); // set scale of image
+    Sprite finalback; // gets its texture when it has loaded
 
     // text settings for score and level
-
-    Font scorefont;
-    if (!scorefont.loadFromFile("fonts/VideoPhreak.ttf"))
+    Font *scorefont = assets.font("fonts/VideoPhreak.ttf");
+    if (!scorefont)
     {
         return EXIT_FAILURE;
     }
 
-    Text scoretext; // text item that displays the current score
-    scoretext.setFont(scorefont);
-    unsigned int score = 0;
-    scoretext.setString("SCORE 0");
-    scoretext.setFillColor(sf::Color::Cyan);
-    scoretext.setCharacterSize(64);
-    scoretext.setPosition(10.f,10.f);
-
-    Font levelfont;
-    if (!levelfont.loadFromFile("fonts/VideoPhreak.ttf"))
-    {
+    Hud hud(*scorefont, *t9); // score, level and life icons, redrawn only when one of them changes
+    if (!hud.create(W, H))
         return EXIT_FAILURE;
-    }
-    unsigned int level = 1;
-    Text leveltext; // text item that displays the current level
-    leveltext.setFont(levelfont);
-    leveltext.setString("LEVEL 1");
-    leveltext.setFillColor(sf::Color::Yellow);
-    leveltext.setCharacterSize(50);
-    leveltext.setPosition(960.f, 700.f);
-
-    Text gameover; // gameover displayed when lives = 0
-    gameover.setFont(levelfont);
-    gameover.setString("GAME OVER");
-    gameover.setFillColor(sf::Color::Red);
-    gameover.setCharacterSize(110);
-    gameover.setPosition(275.f,310.f);
-
-    std::list<Entity *> entities;
-
+    hud.setScore(world.score); // not where a new game starts after --load
+    hud.setLevel(world.level);
+    hud.setLives(world.lives);
+
+    Text overlay; // F2, where the frame time goes
+    overlay.setFont(*scorefont);
+    overlay.setFillColor(sf::Color::White);
+    overlay.setCharacterSize(18);
+    overlay.setPosition(10.f, 90.f);
+    bool showProfile = false;
+    char line[256];
+
+    profileRecord("load assets", loadStart);
     music.play();
 
-    for (int i = 0; i < 15; i++) {
-        asteroid *a = new asteroid();
-        a->settings(sRock, rand() % W, rand() % H, rand() % 360, 25);
-        entities.push_back(a);
-    }
-
-    player *p = new player();
-    p->settings(sPlayer, 200, 200, 0, 20);
-    entities.push_back(p);
-
-    double time = 0; // measures seconds passed in game assuming frame rate = 60/s
-    int lives = 3;
+    // the game ticks at a fixed rate whatever the display is doing. Real time piles up in behind, whole ticks
+    // are taken out of it, and what is left over says how far to blend between the last two ticks when drawing
+    const float tickTime = 1.0f / world.hz;
+    const int MAX_TICKS = 8; // most ticks caught up per frame, a long stall slows the game down instead of snowballing
+    Clock clock, netClock, sinceSnapshot;
+    float behind = 0;
+    bool fire = false; // space pressed since the last tick
 
     /////main loop/////
     while (app.isOpen()) {
-
-        scoretext.setString("SCORE "+std::to_string(score));
-        leveltext.setString("LEVEL "+std::to_string(level));
+        uint64_t phase = profileNow();
 
         Event event; // events are anything done by the human on keyboard or mouse (clicking or typing a key)
         while (app.pollEvent(event)) {
             if (event.type == Event::Closed)
                 app.close();
 
-            if (event.type == Event::KeyPressed)
-                if (event.key.code == Keyboard::Space) {
-                    bullet *b = new bullet();
-                    b->settings(sBullet, p->x, p->y, p->angle, 10);
-                    entities.push_back(b);
-                }
-        }
-
-        if (Keyboard::isKeyPressed(Keyboard::Right)) p->angle += 3; // sets game control keys
-        if (Keyboard::isKeyPressed(Keyboard::Left)) p->angle -= 3;
-        if (Keyboard::isKeyPressed(Keyboard::Up)) p->thrust = true;
-        else p->thrust = false;
-
-
-        for (auto a:entities) // explosions display -- goes through all entities on screen to check and see if any/which collisions are happening
-            for (auto b:entities) {
-                if (a->name == "asteroid" && b->name == "bullet")
-                    if (isCollide(a, b)) {
-                        a->life = false;
-                        b->life = false;
-
-                        Entity *e = new Entity();
-                        e->settings(sExplosion, a->x, a->y);
-                        e->name = "explosion";
-                        entities.push_back(e);
-
-                        astsound.play();
-                        score += 33; // 33 points added to score for shooting an asteroid
-
-                        for (int i = 0; i < 2; i++) {
-                            if (a->R == 15) continue;
-                            Entity *e = new asteroid();
-                            e->settings(sRock_small, a->x, a->y, rand() % 360, 15);
-                            entities.push_back(e);
-                        }
-
-                    }
-
-                if (a->name == "player" && b->name == "asteroid") // asteroid/player collision
-                    if (isCollide(a, b)) {
-                        b->life = false;
-
-                        Entity *e = new Entity();
-                        e->settings(sExplosion_ship, a->x, a->y);
-                        e->name = "explosion";
-                        entities.push_back(e); // adds new explosion to entities list to be displayed
-
-                        if (score >=15)
-                            score -= 15; // 15 points lost for hitting asteroid
-                        else
-                            score = 0;
-                        p->settings(sPlayer, W / 2, H / 2, 0, 20);
-                        p->dx = 0; // resets player to the center of screen ****** LIFE CODE *******
-                        p->dy = 0;
-
-                        //removing life icon when lost
-                        if (lives == 3)
-                        {
-                            life3.setColor(sf::Color::Transparent);
-                        }
-                        else if (lives == 2)
-                        {
-                            life2.setColor(sf::Color::Transparent);
-
-                        }
-                        else
-                        {
-                            life1.setColor(sf::Color::Transparent);
-                        }
-                        lives--;
-                    }
-
-                if (a->name == "player" && b->name == "ufo") // ufo/player collision
-                    if (isCollide(a, b)) {
-                        b->life = false;
-
-                        Entity *e = new Entity();
-                        e->settings(sExplosion_ship, a->x, a->y);
-                        e->name = "explosion";
-                        entities.push_back(e); // adds new explosion to entities list to be displayed
-
-                        if (score >= 20)
-                            score -= 20; // 20 points lost for hitting ufo
-                        else
-                            score = 0;
-
-                        ufosound.pause();
-
-                        p->settings(sPlayer, W / 2, H / 2, 0, 20);
-                        p->dx = 0; // resets player to the center of screen ****** LIFE CODE *******
-                        p->dy = 0;
-
-                        // displaying lives icons/removing when life is lost
-                        if (lives == 3)
-                        {
-                            life3.setColor(sf::Color::Transparent);
-                        }
-                        else if (lives == 2)
-                        {
-                            life2.setColor(sf::Color::Transparent);
-
-                        }
-                        else
-                        {
-                            life1.setColor(sf::Color::Transparent);
-                        }
-                        lives--;
-                    }
-
-                if (a->name == "ufo" && b->name == "bullet") // ufo/bullet collision
-                    if (isCollide(a, b)) {
-                        a->life = false; // scheduled to be deleted
-                        b->life = false;
-
-                        Entity *e = new Entity(); // adds explosion to entities list to be displayed
-                        e->settings(sExplosion, a->x, a->y);
-                        e->name = "explosion";
-                        entities.push_back(e);
-
-                        score += 75; // 75 points for shooting a ufo
-
-                        ufosound.pause();
-
-//                        for (int i = 0; i < 2; i++) {
-//                            if (a->R == 15) continue;
-//                            Entity *e = new asteroid();
-//                            e->settings(sRock_small, a->x, a->y, rand() % 360, 15);
-//                            entities.push_back(e);
-//                        }
-
+            if (event.type == Event::KeyPressed) {
+                if (event.key.code == Keyboard::Space)
+                    fire = true;
+                if (event.key.code == Keyboard::F1) // debug view of the collision circles
+                    renderer.showHitCircles = !renderer.showHitCircles;
+                if (event.key.code == Keyboard::F2)
+                    showProfile = !showProfile;
+                if (event.key.code == Keyboard::F5 && canLoad) { // quick save, kept in memory and on disk
+                    world.save(quicksave);
+                    FILE *f = fopen("quicksave.sav", "wb");
+                    if (f) {
+                        fwrite(quicksave.data(), 1, quicksave.size(), f);
+                        fclose(f);
                     }
-            }
-
-
-        if (p->thrust) p->anim = sPlayer_go; // go animation used when up key is pressed to move forward
-        else p->anim = sPlayer;
-
-
-        for (auto e:entities)
-            if (e->name == "explosion")
-                if (e->anim.isEnd()) e->life = 0;
-
-//        if (rand() % 150 == 0) // PART 3 ?? CREATES NEW ASTEROIDS
-//        {
-//            asteroid *a = new asteroid();
-//            a->settings(sRock, 0, rand() % H, rand() % 360, 25);
-//            entities.push_back(a);
-//        }
-
-        if (asteroid::getCount() == 0) // increasing the difficulty of each level by adding more and more asteroids each level
-        {
-            if (level != 5) {
-                level++;
-            }
-            if (level == 2) {
-                for (int i = 0; i < 15; i++) { // calling asteroid constructor
-                    asteroid *a = new asteroid();
-                    a->settings(sRock, rand() % W, rand() % H, rand() % 360, 25);
-                    entities.push_back(a);
                 }
-            }
-            if (level == 3)
-            {
-                for (int i = 0; i < 25; i++) {
-                    asteroid *a = new asteroid();
-                    a->settings(sRock, rand() % W, rand() % H, rand() % 360, 25);
-                    entities.push_back(a);
-                }
-            }
-            if (level == 4)
-            {
-                for (int i = 0; i < 34; i++) {
-                    asteroid *a = new asteroid();
-                    a->settings(sRock, rand() % W, rand() % H, rand() % 360, 25);
-                    entities.push_back(a);
+                if (event.key.code == Keyboard::F9 && canLoad && !quicksave.empty()) { // quick load
+                    if (!world.restore(quicksave.data(), quicksave.size())) {
+                        fprintf(stderr, "quick save didn't load\n");
+                        world.reset(seed);
+                    }
+                    hud.setScore(world.score);
+                    hud.setLevel(world.level);
+                    hud.setLives(world.lives);
                 }
             }
-            if (level == 5) // final level
-            {
-                for (int i = 0; i < 45; i++) {
-                    asteroid *a = new asteroid();
-                    a->settings(sRock, rand() % W, rand() % H, rand() % 360, 25);
-                    entities.push_back(a);
+        }
+        profileRecord("events", phase);
+
+        behind += clock.restart().asSeconds() * speed;
+        if (behind > MAX_TICKS * speed * tickTime) behind = MAX_TICKS * speed * tickTime;
+
+        while (behind >= tickTime) {
+            PROFILE_SCOPE("tick");
+            Input in;
+            if (replayPath) {
+                if (!playback.next(in)) { // recording is over
+                    app.close();
+                    break;
                 }
+            } else {
+                in.right = Keyboard::isKeyPressed(Keyboard::Right); // sets game control keys
+                in.left = Keyboard::isKeyPressed(Keyboard::Left);
+                in.thrust = Keyboard::isKeyPressed(Keyboard::Up);
+                in.fire = fire; // one bullet per press, on the first tick after it
             }
-        }
+            fire = false;
 
-        // ****** NEED SIMILAR CODE TO ADD UFO TO ENTITIES LIST
-
-        //use static count for ufo to make sure only one ufo is on the screen at a time
-            if (rand() % 100 == 25 && ufo::getCount() == 0) {
-                ufo *u = new ufo();
-                u->settings(sUFO, 0, rand() % H, 270, 40);
-                entities.push_back(u);
-                ufosound.play();
+            if (host) { // the server plays the tick
+                net.send(in, netClock.getElapsedTime().asMilliseconds());
+                net.effects.update(world.dt);
+                behind -= tickTime;
+                continue;
             }
 
-            if (ufo::getCount() == 1)
-            {
-                // && no longer on screen { ufosound.pause(); }
+            world.step(in);
+            behind -= tickTime;
+            recording.record(in, world);
+            if (replayPath && !playback.check(world)) {
+                fprintf(stderr, "replay diverged at tick %ld\n", playback.divergedAt);
+                app.close();
+                break;
             }
 
+            for (auto &ev:world.events) { // sounds and life icons for what just happened
+                if (ev.type == EV_ASTEROID_HIT) mixer.trigger(*astbuff, 1, ev.x); // asteroid explosion noise
+                if (ev.type == EV_UFO_SPAWN) mixer.trigger(*ufobuff, 2, ev.x, ev.entity); // stops when the ufo dies or leaves
+                if (ev.type == EV_SCORE) hud.setScore(world.score);
+                if (ev.type == EV_LEVEL_UP) hud.setLevel(world.level);
+                if (ev.type == EV_PLAYER_HIT) hud.setLives(world.lives); //removing life icon when lost
+            }
+        }
 
-        for (auto i = entities.begin(); i != entities.end();) {
-            Entity *e = *i;
-
-            e->update(); // dynamically finds out which update() derived class to use based on type of e
-            e->anim.update();
+        if (host && net.receive()) {
+            const Snapshot &s = *net.latest();
+            world.score = s.score; // only for the HUD and the background
+            world.level = s.level;
+            world.lives = s.lives;
+            hud.setScore(s.score);
+            hud.setLevel(s.level);
+            hud.setLives(s.lives);
+            sinceSnapshot.restart();
+        }
+        const EntityStore &shown = host ? net.store : world.store;
+        const Effects &effects = host ? net.effects : world.effects;
+        float alpha = behind / tickTime;
+        if (host) { // blend over a tick from the snapshot before, they don't come in step with the frames here
+            alpha = sinceSnapshot.getElapsedTime().asSeconds() / tickTime;
+            if (alpha > 1) alpha = 1;
+        }
 
-            if (e->life == false) {
-                i = entities.erase(i);
-                delete e;
-            } // if entity e has been scheduled by update() to be deleted, destructor is called and e is deleted
-            else i++;
+        if (world.scrolling()) { // on the ship where it is drawn, not where the last tick left it
+            renderer.arena = Vector2f(world.width, world.height);
+            if (shown.alive(world.p)) {
+                Ref r = shown.find(world.p);
+                camera.setCenter(renderer.blended(shown.kinds[r.kind], r.index, alpha));
+            }
         }
+        mixer.listen(camera.getCenter().x, renderer.arena.x);
+
+        phase = profileNow();
+        mixer.update(shown);
+        profileRecord("mixer", phase);
 
         //////draw//////
+        phase = profileNow();
+
+        if (world.level >= 4 && !t12) { // the last background starts loading a level early
+            assets.request("images/finallevelback.jpg");
+            if (assets.ready("images/finallevelback.jpg") && (t12 = assets.texture("images/finallevelback.jpg")))
+                finalback.setTexture(*t12, true);
+        }
 
-        if (level < 5) {
+        if (world.level < 5 || !t12) {
             app.draw(background); //draw creates the pictures, but does not display yet
         }
         else {
             app.draw(finalback);
         }
-        if (lives > 0)
-        {
-            app.draw(scoretext); // draw stuff necessary for the game
-            app.draw(leveltext);
-            app.draw(life1);
-            app.draw(life2);
-            app.draw(life3);
-        }
-        else {
-            app.draw(gameover);
-            app.draw(scoretext);
+        drawCalls += 1;
+        hud.draw(app); // draw stuff necessary for the game
+        drawCalls += 1;
+
+        app.setView(camera); // the background and hud stay put, only the world scrolls
+        renderer.draw(app, shown, effects, alpha); // draw entities with life = 0
+        app.setView(app.getDefaultView());
+        drawCalls += renderer.drawCalls;
+
+        if (showProfile) {
+            FrameStats st;
+            if (profileStats(st))
+                snprintf(line, sizeof line, "frame ms  p50 %.2f  p95 %.2f  p99 %.2f  worst %.2f\n"
+                                            "allocs/frame %.1f\n", st.p50, st.p95, st.p99, st.worst, st.allocs);
+            else
+                snprintf(line, sizeof line, "profiler compiled out of this build\n");
+            std::string text = line;
+            snprintf(line, sizeof line, "rocks %lu  ufos %lu  bullets %lu  effects %lu",
+                     (unsigned long) shown.kinds[KIND_ASTEROID].size(), (unsigned long) shown.kinds[KIND_UFO].size(),
+                     (unsigned long) shown.kinds[KIND_BULLET].size(), (unsigned long) effects.live());
+            text += line;
+            if (world.scrolling()) {
+                snprintf(line, sizeof line, "\nparked %lu  culled %lu", (unsigned long) world.sectors.parkedCount(),
+                         (unsigned long) renderer.culled);
+                text += line;
+            }
+            overlay.setString(text);
+            app.draw(overlay);
+            drawCalls++;
         }
+        profileRecord("draw", phase);
 
-        for (auto i:entities)
-            i->draw(app); // draw entities with life = 0
-
+        phase = profileNow();
         app.display(); // display() displays drawn entities
-
-        //time += static_cast<double>(1)/60;
+        profileRecord("display", phase);
+        profileFrame();
+
+        if (stats && ++frames == 60) {
+            printf("%.1f draw calls per frame\n", drawCalls / 60.0);
+            if (host && net.snapshots) {
+                printf("%lu snapshots, %.0f bytes each, decode %.2f us, %lu couldn't be decoded\n", net.snapshots,
+                       (double) net.bytes / net.snapshots, net.decodeNs / net.snapshots / 1000, net.undecodable);
+                net.snapshots = net.bytes = net.undecodable = 0;
+                net.decodeNs = 0;
+            }
+            drawCalls = frames = 0;
+        }
     }
 
+    if (tracePath && !profileTrace(tracePath))
+        fprintf(stderr, "no trace, profiling is compiled out of this build\n");
+    if (replayPath && playback.divergedAt < 0)
+        printf("replay matched, %lu hash checks passed\n", playback.checks);
     return 0;
 }
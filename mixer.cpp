@@ -0,0 +1,97 @@
+#include "mixer.h"
+
+#include <cmath>
+
+#include "world.h"
+
+Mixer::Mixer(int voices) : voices(voices), frame(0), listenerX(W / 2), arenaWidth(W) {
+    pending.reserve(voices);
+    for (auto &v:this->voices) {
+        v.priority = 0;
+        v.started = 0;
+        v.owned = false;
+        v.sound.setRelativeToListener(true); // positions are left/right of the listener, not in the world
+        v.sound.setMinDistance(1);
+        v.sound.setAttenuation(0); // panning only, no fading with distance
+    }
+}
+
+void Mixer::trigger(const sf::SoundBuffer &buffer, int priority, float x, Handle owner) {
+    bool owned = owner.slot != Handle().slot;
+    for (auto &t:pending) {
+        if (t.buffer != &buffer) continue;
+        if (priority > t.priority) t.priority = priority; // ten rocks breaking on one frame is still one bang
+        if (owned && !t.owned) {
+            t.owner = owner;
+            t.owned = true;
+        }
+        return;
+    }
+
+    Trigger t = {&buffer, priority, x, owner, owned};
+    pending.push_back(t);
+}
+
+void Mixer::update(const EntityStore &store) {
+    frame++;
+
+    for (auto &v:voices) { // owned voices follow their entity and stop with it
+        if (!v.owned || v.sound.getStatus() == sf::Sound::Stopped) continue;
+        if (!store.alive(v.owner)) {
+            v.sound.stop();
+            v.owned = false;
+            continue;
+        }
+        Ref r = store.find(v.owner);
+        pan(v, store.kinds[r.kind].x[r.index]);
+    }
+
+    for (auto &t:pending) {
+        Voice *v = pick(t.priority);
+        if (!v) continue; // dropped, everything playing is more important
+
+        v->sound.stop();
+        v->sound.setBuffer(*t.buffer);
+        v->priority = t.priority;
+        v->started = frame;
+        v->owner = t.owner;
+        v->owned = t.owned;
+        pan(*v, t.x);
+        v->sound.play();
+    }
+    pending.clear();
+}
+
+int Mixer::playing() const {
+    int n = 0;
+    for (auto &v:voices)
+        if (v.sound.getStatus() != sf::Sound::Stopped) n++;
+    return n;
+}
+
+Mixer::Voice *Mixer::pick(int priority) {
+    Voice *best = 0;
+    for (auto &v:voices) {
+        if (v.sound.getStatus() == sf::Sound::Stopped) return &v;
+        if (v.priority > priority) continue;
+        if (!best || v.priority < best->priority || (v.priority == best->priority && v.started < best->started))
+            best = &v;
+    }
+    return best;
+}
+
+void Mixer::listen(float x, float arenaWidth) {
+    listenerX = x;
+    this->arenaWidth = arenaWidth;
+}
+
+void Mixer::pan(Voice &v, float x) {
+    // a point on a unit circle in front of the listener, -1 = hard left, 1 = hard right. Only mono buffers pan
+    float d = x - listenerX;
+    if (d > arenaWidth / 2) d -= arenaWidth;
+    if (d < -arenaWidth / 2) d += arenaWidth;
+    float p = d / (W / 2);
+    if (p < -1) p = -1;
+    if (p > 1) p = 1;
+    v.sound.setPosition(p, 0, -std::sqrt(1 - p * p));
+}
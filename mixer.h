@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SOUND MIXER
+// DESCRIPTION: A fixed set of voices (sf::Sound) made once at startup and shared by every sound effect.
+// Sounds are triggered during the frame and started together in update():
+//  - the same sound triggered more than once in a frame only plays once, at its highest priority
+//  - with every voice busy, the lowest priority voice is stolen, the oldest of those if there is a tie.
+//    A sound never steals a voice playing something more important than itself
+//  - each sound is panned left or right by the x where it happened, from the middle of the screen, which in
+//    a scrolling arena is wherever the camera is
+//  - a sound can belong to an entity, it then follows that entity's x and stops when the entity is gone
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_MIXER_H
+#define ASTEROIDS_MIXER_H
+
+#include <SFML/Audio.hpp>
+#include <vector>
+
+#include "entities.h"
+
+class Mixer {
+public:
+    explicit Mixer(int voices = 16);
+
+    // plays buffer at the next update(). owner = the entity the sound belongs to, if any
+    void trigger(const sf::SoundBuffer &buffer, int priority, float x, Handle owner = Handle());
+
+    void update(const EntityStore &store); // once a frame after the world has stepped
+
+    int playing() const; // voices in use
+
+    // the screen's middle is at x in an arena this wide, sounds pan from there the short way round its edges
+    void listen(float x, float arenaWidth);
+
+private:
+    struct Voice {
+        sf::Sound sound;
+        int priority;
+        unsigned long started; // frame it was started on
+        Handle owner;
+        bool owned;
+    };
+
+    struct Trigger {
+        const sf::SoundBuffer *buffer;
+        int priority;
+        float x;
+        Handle owner;
+        bool owned;
+    };
+
+    std::vector<Voice> voices;
+    std::vector<Trigger> pending; // this frame's triggers, capacity kept between frames
+    unsigned long frame;
+    float listenerX, arenaWidth;
+
+    Voice *pick(int priority); // a free voice, or one to steal, 0 when everything playing matters more
+    void pan(Voice &v, float x);
+};
+
+#endif
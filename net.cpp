@@ -0,0 +1,235 @@
+#include "net.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "replay.h"
+
+namespace {
+
+const unsigned long TIMEOUT = 5000; // ms without a packet before a client is dropped
+const int MAX_PEERS = 8;
+
+void putTick(std::vector<uint8_t> &out, unsigned long tick) {
+    for (int i = 0; i < 8; i++)
+        out.push_back((uint8_t) ((uint64_t) tick >> (8 * i)));
+}
+
+unsigned long getTick(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t) p[i] << (8 * i);
+    return (unsigned long) v;
+}
+
+LossyLink makeLink(const LinkSettings &s, uint64_t seed) {
+    LossyLink link(seed);
+    link.loss = s.loss;
+    link.latency = s.latency;
+    link.jitter = s.jitter;
+    return link;
+}
+
+// a rock or ufo missing from cur was shot or run into, and a life lost means the ship blew up where it was
+void startEffects(const Snapshot &prev, const Snapshot &cur, Effects &effects) {
+    size_t j = 0;
+    for (auto &e:prev.entities) {
+        while (j < cur.entities.size() && cur.entities[j].slot < e.slot) j++;
+        if (j < cur.entities.size() && cur.entities[j].slot == e.slot && cur.entities[j].generation == e.generation)
+            continue; // still there
+
+        float x = netX(e.x), y = netX(e.y);
+        if (e.kind == KIND_ASTEROID) {
+            effects.explosion(x, y, ANIM_EXPLOSION);
+            effects.debris(x, y, e.R < 20 * 256 ? 4 : 8);
+        }
+        if (e.kind == KIND_UFO && x < W - 10) effects.explosion(x, y, ANIM_EXPLOSION); // not just flown off the edge
+    }
+    if (cur.lives >= prev.lives) return;
+    for (auto &e:prev.entities)
+        if (e.kind == KIND_PLAYER) effects.explosion(netX(e.x), netX(e.y), ANIM_EXPLOSION_SHIP);
+}
+
+double nsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+NetServer::NetServer(const LinkSettings &link) :
+        ticks(0), bytes(0), encodeNs(0), settings(link), buffer(sf::UdpSocket::MaxDatagramSize) {}
+
+bool NetServer::open(unsigned short port) {
+    if (socket.bind(port) != sf::Socket::Done) return false;
+    socket.setBlocking(false);
+    return true;
+}
+
+void NetServer::receive(unsigned long now) {
+    size_t n;
+    sf::IpAddress from;
+    unsigned short fromPort;
+    while (socket.receive(buffer.data(), buffer.size(), n, from, fromPort) == sf::Socket::Done) {
+        if (n != 10 || buffer[0] != 'I') continue; // not ours
+
+        Peer *p = 0;
+        for (auto &q:peers)
+            if (q.address == from && q.port == fromPort) p = &q;
+        if (!p) {
+            if ((int) peers.size() == MAX_PEERS) continue;
+            Peer fresh = {from, fromPort, 0, now, 0, false, makeLink(settings, peers.size() + 1)};
+            peers.push_back(fresh);
+            p = &peers.back();
+            printf("client %s:%u connected%s\n", from.toString().c_str(), fromPort,
+                   peers.size() == 1 ? ", flying the ship" : ", watching");
+        }
+
+        unsigned long ack = getTick(&buffer[1]);
+        if (ack > p->ack) p->ack = ack; // packets can come out of order, an older ack says nothing new
+        p->bits = buffer[9];
+        p->fire = p->fire || (buffer[9] & 8); // a press isn't lost just because the next packet came first
+        p->heard = now;
+    }
+
+    for (size_t i = 0; i < peers.size();) {
+        if (now - peers[i].heard > TIMEOUT) {
+            printf("client %s:%u timed out\n", peers[i].address.toString().c_str(), peers[i].port);
+            peers.erase(peers.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+Input NetServer::input() {
+    if (peers.empty()) return Input();
+    Peer &p = peers[0];
+    Input in = inputFromBits(p.bits);
+    in.fire = p.fire;
+    p.fire = false;
+    return in;
+}
+
+void NetServer::send(const World &world, unsigned long now) {
+    Snapshot &cur = history.slot(world.tick);
+    takeSnapshot(world, cur);
+
+    for (auto &p:peers) {
+        auto start = std::chrono::steady_clock::now();
+        encodeSnapshot(history.find(p.ack), cur, body); // a full one when it has no ack we still have
+        packet.assign(1, 'S');
+        packet.insert(packet.end(), body.begin(), body.end());
+        encodeNs += nsSince(start);
+
+        bytes += packet.size();
+        p.link.send(packet.data(), packet.size(), now);
+        flush(p, now);
+    }
+    ticks++;
+}
+
+void NetServer::flush(Peer &p, unsigned long now) {
+    while (p.link.receive(packet, now))
+        socket.send(packet.data(), packet.size(), p.address, p.port);
+}
+
+NetClient::NetClient(const LinkSettings &link) :
+        snapshots(0), bytes(0), undecodable(0), decodeNs(0), port(0), link(makeLink(link, 99)), newest(0),
+        shown(0), buffer(sf::UdpSocket::MaxDatagramSize) {}
+
+bool NetClient::connect(const char *host, unsigned short serverPort) {
+    server = sf::IpAddress(host);
+    port = serverPort;
+    if (server == sf::IpAddress::None || socket.bind(sf::Socket::AnyPort) != sf::Socket::Done) return false;
+    socket.setBlocking(false);
+    return true;
+}
+
+void NetClient::send(const Input &in, unsigned long now) {
+    packet.clear();
+    packet.push_back('I');
+    putTick(packet, newest);
+    packet.push_back(inputBits(in));
+    link.send(packet.data(), packet.size(), now);
+
+    while (link.receive(packet, now))
+        socket.send(packet.data(), packet.size(), server, port);
+}
+
+bool NetClient::receive() {
+    size_t n;
+    sf::IpAddress from;
+    unsigned short fromPort;
+    while (socket.receive(buffer.data(), buffer.size(), n, from, fromPort) == sf::Socket::Done) {
+        if (n < 2 || buffer[0] != 'S' || from != server || fromPort != port) continue;
+        bytes += n;
+
+        unsigned long tick, back;
+        if (!snapshotBase(&buffer[1], n - 1, tick, back) || tick <= newest) continue; // garbled, or overtaken
+        const Snapshot *base = back ? history.find(tick - back) : 0;
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = (!back || base) && decodeSnapshot(base, &buffer[1], n - 1, decoded);
+        decodeNs += nsSince(start);
+        if (!ok) { // the next one will be against an older ack, or full
+            undecodable++;
+            continue;
+        }
+        std::swap(history.slot(tick), decoded); // the base may share the slot, so decode aside first
+        newest = tick;
+        snapshots++;
+    }
+
+    if (newest == shown) return false;
+    if (const Snapshot *before = history.find(shown)) startEffects(*before, *history.find(newest), effects);
+    applySnapshot(history.find(shown), *history.find(newest), store); // blends from the one drawn before
+    shown = newest;
+    return true;
+}
+
+int runServer(unsigned short port, const LinkSettings &link, unsigned int seed, int hz, bool continuous) {
+    NetServer server(link);
+    if (!server.open(port)) {
+        fprintf(stderr, "can't listen on port %u\n", port);
+        return 1;
+    }
+    printf("serving on port %u at %d Hz, latency %u ms jitter %u ms loss %.0f%%\n", port, hz, link.latency,
+           link.jitter, link.loss * 100);
+
+    World world(seed, hz);
+    world.continuous = continuous;
+
+    const float tickTime = 1.0f / hz;
+    sf::Clock clock, report, uptime;
+    float behind = 0;
+    while (world.lives > 0) {
+        behind += clock.restart().asSeconds();
+        if (behind > 8 * tickTime) behind = 8 * tickTime;
+        unsigned long now = uptime.getElapsedTime().asMilliseconds();
+        if (!server.clients()) { // nobody to play yet, the game waits
+            server.receive(now);
+            behind = 0;
+        }
+
+        while (behind >= tickTime) {
+            server.receive(now);
+            world.step(server.input());
+            server.send(world, now);
+            behind -= tickTime;
+        }
+
+        if (report.getElapsedTime().asSeconds() >= 1) {
+            report.restart();
+            if (server.ticks)
+                printf("tick %lu: %lu clients, %.0f bytes/tick per client, encode %.2f us\n", world.tick,
+                       (unsigned long) server.clients(), (double) server.bytes / server.ticks /
+                       std::max<size_t>(1, server.clients()), server.encodeNs / server.ticks / 1000);
+            server.ticks = server.bytes = 0;
+            server.encodeNs = 0;
+        }
+        sf::sleep(sf::milliseconds(1));
+    }
+    printf("game over, score %u\n", world.score);
+    return 0;
+}
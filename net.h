@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - NETWORK PLAY
+// DESCRIPTION: An authoritative server and its clients over UDP. The server runs the only World. Clients send
+// their keys every tick along with the newest snapshot they have (the ack), the server steps the game and
+// sends each client a delta snapshot against its ack (see snapshot.h). The first client to connect flies the
+// ship, anyone after that watches. A client that goes quiet for five seconds is dropped.
+// Explosions aren't sent, the client starts its own where a rock, ufo or the ship was lost.
+// Every packet either end sends first goes through a LossyLink, so latency, jitter and loss can be tried out
+// with both ends on localhost. Packets: 'I' ack (8 bytes) input bits, and 'S' encoded snapshot.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_NET_H
+#define ASTEROIDS_NET_H
+
+#include <SFML/Network.hpp>
+#include <vector>
+
+#include "lossy_link.h"
+#include "snapshot.h"
+#include "world.h"
+
+struct LinkSettings { // what the LossyLinks are set to
+    float loss; // 0..1
+    unsigned int latency, jitter; // milliseconds
+
+    LinkSettings() : loss(0), latency(0), jitter(0) {}
+};
+
+class NetServer {
+public:
+    unsigned long ticks, bytes; // snapshots sent to all clients since the last report, and their size
+    double encodeNs;
+
+    explicit NetServer(const LinkSettings &link);
+
+    bool open(unsigned short port);
+
+    void receive(unsigned long now); // keys and acks, an address not heard from before becomes a client
+    Input input(); // the first client's keys for the next tick
+    void send(const World &world, unsigned long now); // a snapshot of the tick just played to every client
+
+    size_t clients() const { return peers.size(); }
+
+private:
+    struct Peer {
+        sf::IpAddress address;
+        unsigned short port;
+        unsigned long ack; // newest snapshot it has
+        unsigned long heard; // when it last sent anything
+        unsigned char bits; // keys it is holding
+        bool fire; // fire pressed since the last tick, in any packet
+        LossyLink link; // everything sent to it goes through here
+    };
+
+    LinkSettings settings;
+    sf::UdpSocket socket;
+    std::vector<Peer> peers;
+    SnapshotRing history;
+    std::vector<uint8_t> packet, body, buffer; // buffer stays the size of the biggest datagram for receiving
+
+    void flush(Peer &p, unsigned long now); // packets the link has let through go out on the socket
+};
+
+class NetClient {
+public:
+    EntityStore store; // the last snapshot as entities, for drawing
+    Effects effects; // not sent, started here from what disappeared between snapshots. update() once a tick
+    unsigned long snapshots, bytes, undecodable; // since the last report
+    double decodeNs;
+
+    explicit NetClient(const LinkSettings &link);
+
+    bool connect(const char *host, unsigned short port);
+
+    void send(const Input &in, unsigned long now); // once a tick
+    bool receive(); // true when a newer snapshot came in and store has been rebuilt from it
+
+    const Snapshot *latest() const { return history.find(newest); } // 0 until the first snapshot
+
+private:
+    sf::IpAddress server;
+    unsigned short port;
+    sf::UdpSocket socket;
+    LossyLink link;
+    SnapshotRing history;
+    Snapshot decoded;
+    unsigned long newest, shown; // newest snapshot decoded, the one store was built from
+    std::vector<uint8_t> packet, buffer;
+};
+
+// plays a game for whoever connects, until the ship runs out of lives. Waits for the first client to start
+int runServer(unsigned short port, const LinkSettings &link, unsigned int seed, int hz, bool continuous);
+
+#endif
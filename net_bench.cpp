@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SNAPSHOT BENCHMARK
+// DESCRIPTION: A server and one client in the same process, talking through a pair of LossyLinks instead of
+// sockets. The server plays the scripted pilot's game with the rocks topped up to a number (90 by default, the
+// level 5 wave of 45 once it has started splitting) and sends a delta snapshot after every tick against the
+// client's last ack. The client decodes whatever arrives, checks it against what the server had for that tick
+// and acks it. Reports bytes per tick against the size of a full snapshot, encode and decode time, and how many
+// snapshots were lost or arrived too late to decode.
+// USAGE: net_bench [ticks] [rocks] [latency ms] [loss %] [jitter ms]
+///////////////////////////////////////////////////
+
+#include "lossy_link.h"
+#include "snapshot.h"
+#include "world.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+bool framesInClip(const Snapshot &s) { // every frame cursor indexes a picture that's there
+    for (auto &e:s.entities)
+        if (e.frame >= CLIPS[e.clip].count * 256) return false;
+    return true;
+}
+
+double nsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    unsigned long ticks = argc > 1 ? strtoul(argv[1], 0, 10) : 20000;
+    size_t rocks = argc > 2 ? strtoul(argv[2], 0, 10) : 90;
+    LossyLink down(1), up(2); // server to client, client to server
+    down.latency = up.latency = argc > 3 ? atoi(argv[3]) : 50;
+    down.loss = up.loss = argc > 4 ? atof(argv[4]) / 100 : 0.05f;
+    down.jitter = up.jitter = argc > 5 ? atoi(argv[5]) : 10;
+
+    World world(1);
+
+    SnapshotRing sent, received; // server's history, client's history
+    Snapshot decoded, full;
+    std::vector<uint8_t> packet, fullPacket, in;
+    unsigned long ack = 0; // server: newest tick the client has said it has
+    unsigned long latest = 0; // client: newest tick it has decoded
+
+    unsigned long bytes = 0, biggest = 0, fullBytes = 0, fulls = 0, entities = 0;
+    unsigned long arrived = 0, stale = 0, noBase = 0, bad = 0, mismatches = 0, outOfClip = 0;
+    double encodeNs = 0, decodeNs = 0;
+
+    for (unsigned long t = 0; t < ticks; t++) {
+        unsigned long now = t * 1000 / world.hz;
+
+        while (up.receive(in, now)) { // acks
+            unsigned long tick = 0;
+            for (size_t i = 0; i < in.size() && i < 8; i++) tick |= (unsigned long) in[i] << (8 * i);
+            if (tick > ack) ack = tick;
+        }
+
+        world.step(pilot(world.tick));
+        if (world.store.kinds[KIND_ASTEROID].size() < rocks) world.spawnRocks(1); // stay at the density asked for
+        Snapshot &cur = sent.slot(world.tick);
+        takeSnapshot(world, cur);
+        entities += cur.entities.size();
+        if (!framesInClip(cur)) outOfClip++;
+
+        auto start = std::chrono::steady_clock::now();
+        encodeSnapshot(sent.find(ack), cur, packet); // a full one when the ack has fallen out of the history
+        encodeNs += nsSince(start);
+        bytes += packet.size();
+        if (packet.size() > biggest) biggest = packet.size();
+        down.send(packet.data(), packet.size(), now);
+
+        if (t % 60 == 0) { // what it would cost with no deltas
+            encodeSnapshot(0, cur, fullPacket);
+            fullBytes += fullPacket.size();
+            fulls++;
+        }
+
+        while (down.receive(in, now)) {
+            arrived++;
+            unsigned long tick, back;
+            if (!snapshotBase(in.data(), in.size(), tick, back)) {
+                bad++;
+                continue;
+            }
+            if (tick <= latest) { // overtaken by a newer one
+                stale++;
+                continue;
+            }
+            const Snapshot *base = back ? received.find(tick - back) : 0;
+            if (back && !base) {
+                noBase++;
+                continue;
+            }
+
+            start = std::chrono::steady_clock::now();
+            bool ok = decodeSnapshot(base, in.data(), in.size(), decoded);
+            decodeNs += nsSince(start);
+            if (!ok) {
+                bad++;
+                continue;
+            }
+
+            const Snapshot *truth = sent.find(tick);
+            if (truth && !sameSnapshot(*truth, decoded)) mismatches++;
+            if (!framesInClip(decoded)) outOfClip++; // the match above can't see a cursor both ends got wrong
+            std::swap(received.slot(tick), decoded); // the base may share the slot, so decode aside first
+            latest = tick;
+        }
+
+        uint8_t a[8]; // client acks every tick, a lost ack is covered by the next one
+        for (int i = 0; i < 8; i++) a[i] = (uint8_t) (latest >> (8 * i));
+        up.send(a, sizeof a, now);
+    }
+
+    printf("%lu ticks, %.0f entities on average, latency %u ms jitter %u ms loss %.0f%%\n", ticks,
+           (double) entities / ticks, down.latency, down.jitter, down.loss * 100);
+    printf("delta %.0f bytes/tick (%.1f KB/s at %d Hz), biggest %lu, full snapshot %.0f bytes\n",
+           (double) bytes / ticks, bytes / (double) ticks * world.hz / 1024, world.hz, biggest,
+           fulls ? (double) fullBytes / fulls : 0.0);
+    printf("encode %.2f us/tick, decode %.2f us/snapshot\n", encodeNs / ticks / 1000,
+           arrived ? decodeNs / arrived / 1000 : 0.0);
+    printf("sent %lu, dropped %lu, arrived %lu: %lu overtaken, %lu base gone, %lu garbled\n", down.sent, down.dropped,
+           arrived, stale, noBase, bad);
+    if (mismatches) {
+        printf("MISMATCH: %lu decoded snapshots differ from the server's\n", mismatches);
+        return 1;
+    }
+    if (outOfClip) {
+        printf("OUT OF CLIP: %lu snapshots have a frame past the end of its clip\n", outOfClip);
+        return 1;
+    }
+    printf("every decoded snapshot matched the server\n");
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "profile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+static std::atomic<unsigned long> allocations(0);
+
+void countHeapAllocation() {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long heapAllocations() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#if ASTEROIDS_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const size_t RING = 1 << 16; // scopes kept, a power of two so the index can just be masked
+const int FRAME_WINDOW = 240; // frames the overlay looks back over
+
+struct Sample {
+    const char *name;
+    uint64_t start, duration; // ns since the profiler started
+    int thread;
+};
+
+Sample ring[RING];
+std::atomic<uint64_t> head(0); // scopes ever recorded, the next one goes at head % RING
+uint64_t totalled = 0; // scopes profileTotals() has already added up
+
+std::atomic<int> threadCount(0);
+thread_local int threadId = -1;
+
+float frameMs[FRAME_WINDOW];
+unsigned long frameAllocs[FRAME_WINDOW];
+int frameCount = 0;
+uint64_t lastFrame = 0;
+unsigned long lastAllocs = 0;
+
+uint64_t now() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+}
+
+uint64_t profileNow() {
+    return now();
+}
+
+void profileRecord(const char *name, uint64_t start) {
+    uint64_t end = now();
+    if (threadId < 0) threadId = threadCount++;
+
+    Sample &s = ring[head.fetch_add(1, std::memory_order_relaxed) & (RING - 1)];
+    s.name = name;
+    s.start = start;
+    s.duration = end - start;
+    s.thread = threadId;
+}
+
+ProfileScope::ProfileScope(const char *name) : name(name), start(now()) {}
+
+ProfileScope::~ProfileScope() {
+    profileRecord(name, start);
+}
+
+void profileFrame() {
+    uint64_t t = now();
+    unsigned long a = heapAllocations();
+    if (lastFrame) {
+        int i = frameCount++ % FRAME_WINDOW;
+        frameMs[i] = (t - lastFrame) / 1e6f;
+        frameAllocs[i] = a - lastAllocs;
+    }
+    lastFrame = t;
+    lastAllocs = a;
+}
+
+bool profileStats(FrameStats &st) {
+    int n = std::min(frameCount, FRAME_WINDOW);
+    if (!n) return false;
+
+    float sorted[FRAME_WINDOW];
+    unsigned long allocs = 0;
+    for (int i = 0; i < n; i++) {
+        sorted[i] = frameMs[i];
+        allocs += frameAllocs[i];
+    }
+    std::sort(sorted, sorted + n);
+
+    st.p50 = sorted[n * 50 / 100];
+    st.p95 = sorted[n * 95 / 100];
+    st.p99 = sorted[n * 99 / 100];
+    st.worst = sorted[n - 1];
+    st.allocs = (float) allocs / n;
+    st.frames = n;
+    return true;
+}
+
+bool profileTrace(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    uint64_t end = head.load();
+    uint64_t begin = end > RING ? end - RING : 0;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (uint64_t i = begin; i < end; i++) {
+        const Sample &s = ring[i & (RING - 1)];
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                i == begin ? "" : ",\n", s.name, s.thread, s.start / 1e3, s.duration / 1e3);
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(f) == 0;
+}
+
+int profileTotals(PhaseTotal *out, int max) {
+    uint64_t end = head.load();
+    uint64_t begin = std::max(totalled, end > RING ? end - RING : 0);
+    totalled = end;
+
+    int n = 0;
+    for (uint64_t i = begin; i < end; i++) {
+        const Sample &s = ring[i & (RING - 1)];
+        int j = 0;
+        while (j < n && out[j].name != s.name && strcmp(out[j].name, s.name) != 0) j++;
+        if (j == n) {
+            if (n == max) continue;
+            out[n].name = s.name;
+            out[n].ns = 0;
+            out[n].count = 0;
+            n++;
+        }
+        out[j].ns += s.duration;
+        out[j].count++;
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - PROFILER
+// DESCRIPTION: Timing for the phases of a frame. PROFILE_SCOPE("name") times the rest of the block it is in
+// and puts the result in a ring buffer shared by every thread. Writers only bump an atomic index, there is
+// no lock. The last 64k scopes can be saved as a Chrome trace (chrome://tracing or ui.perfetto.dev), and
+// profileFrame() keeps frame times for the overlay.
+// On in debug builds. In release (NDEBUG) all of it compiles away unless ASTEROIDS_PROFILE is defined.
+// Heap allocations are only counted by programs that link alloc_count.cpp, which replaces operator new. The
+// runners and benches always do, the game only when the profiler is compiled in, so a release game keeps the
+// normal allocator.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_PROFILE_H
+#define ASTEROIDS_PROFILE_H
+
+#include <cstdint>
+
+#if defined(ASTEROIDS_PROFILE) || !defined(NDEBUG)
+#define ASTEROIDS_PROFILING 1
+#else
+#define ASTEROIDS_PROFILING 0
+#endif
+
+unsigned long heapAllocations(); // operator new calls so far in the whole process, 0 without alloc_count.cpp
+void countHeapAllocation(); // alloc_count.cpp's operator new calls this
+
+struct FrameStats { // over the last FRAME_WINDOW frames
+    float p50, p95, p99, worst; // frame times in ms
+    float allocs; // heap allocations per frame
+    int frames;
+};
+
+struct PhaseTotal { // time spent in every scope of one name
+    const char *name;
+    uint64_t ns;
+    unsigned long count;
+};
+
+#if ASTEROIDS_PROFILING
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name); // name has to live forever, a string literal
+    ~ProfileScope();
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+
+// for spans that aren't one block, like the asset loading at the top of main()
+uint64_t profileNow();
+void profileRecord(const char *name, uint64_t start); // start..now
+
+void profileFrame(); // end of a frame, once per displayed frame (or per tick headless)
+bool profileStats(FrameStats &st); // false until there is a frame
+bool profileTrace(const char *path); // the ring buffer as Chrome trace JSON, call while the workers are idle
+
+// totals by scope name of everything recorded since the last call (as much as the ring still holds, so call it
+// at least every few thousand ticks). Fills at most max names, returns how many it filled
+int profileTotals(PhaseTotal *out, int max);
+
+#else
+
+#define PROFILE_SCOPE(name) do {} while (0)
+
+inline uint64_t profileNow() { return 0; }
+inline void profileRecord(const char *, uint64_t) {}
+
+inline void profileFrame() {}
+inline bool profileStats(FrameStats &) { return false; }
+inline bool profileTrace(const char *) { return false; }
+inline int profileTotals(PhaseTotal *, int) { return 0; }
+
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+#include "render.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sf;
+
+namespace {
+
+const unsigned ATLAS_WIDTH = 4096; // fits every GPU SFML runs on
+const int PADDING = 2; // gap between frames so smoothing doesn't bleed the neighbours in
+
+struct Piece { // one frame waiting to be packed
+    int anim, frame;
+    const Image *image;
+    IntRect from;
+};
+
+bool tallerFirst(const Piece &a, const Piece &b) {
+    return a.from.height > b.from.height;
+}
+
+float blend(float from, float to, float alpha, float edge) {
+    if (fabs(to - from) > edge / 2) return to; // wrapped around the screen, don't slide back across it
+    return from + (to - from) * alpha;
+}
+
+float blendAngle(float from, float to, float alpha) { // degrees, the short way round through 0
+    float d = to - from;
+    if (d > 180) d -= 360;
+    if (d < -180) d += 360;
+    return from + d * alpha;
+}
+
+float nearest(float v, float centre, float edge) { // the copy of v round the arena that is closest to centre
+    if (v - centre > edge / 2) return v - edge;
+    if (centre - v > edge / 2) return v + edge;
+    return v;
+}
+
+}
+
+bool Atlas::build(Assets &assets) {
+    std::vector<Piece> pieces;
+
+    for (int c = 0; c < ANIM_COUNT; c++) // all the sheets decode at once on the loader threads
+        assets.request(CLIPS[c].file);
+
+    for (int c = 0; c < ANIM_COUNT; c++) {
+        const AnimClip &src = CLIPS[c];
+        const Image *image = assets.image(src.file); // the same Image for every clip cut from one sheet
+        if (!image) return false;
+
+        for (int i = 0; i < src.count; i++) {
+            Piece p = {c, i, image, IntRect(src.x + i * src.w, src.y, src.w, src.h)};
+            pieces.push_back(p);
+        }
+        frames[c].resize(src.count);
+    }
+
+    // shelf packing: tallest frames first, left to right, a new shelf when the row is full
+    std::stable_sort(pieces.begin(), pieces.end(), tallerFirst);
+    int x = 0, y = 0, shelf = 0;
+    for (auto &p:pieces) {
+        if (x + p.from.width > (int) ATLAS_WIDTH) {
+            x = 0;
+            y += shelf + PADDING;
+            shelf = 0;
+        }
+        frames[p.anim][p.frame] = IntRect(x, y, p.from.width, p.from.height);
+        x += p.from.width + PADDING;
+        shelf = std::max(shelf, p.from.height);
+    }
+
+    Image sheet;
+    sheet.create(ATLAS_WIDTH, y + shelf, Color::Transparent);
+    for (auto &p:pieces) {
+        const IntRect &to = frames[p.anim][p.frame];
+        sheet.copy(*p.image, to.left, to.top, p.from);
+    }
+
+    if (!texture.loadFromImage(sheet)) return false;
+    texture.setSmooth(true); // makes pictures smooth
+    return true;
+}
+
+Renderer::Renderer() {
+    showHitCircles = false;
+    drawCalls = 0;
+    culled = 0;
+    arena = Vector2f(W, H);
+    for (int k = 0; k < KIND_COUNT; k++)
+        layers[k].setPrimitiveType(Quads);
+    sparks.setPrimitiveType(Quads);
+    circles.setPrimitiveType(Triangles);
+}
+
+void Renderer::addSprite(VertexArray &va, const IntRect &frame, float x, float y, float angle, float scale,
+                         Color color) {
+    // same as a Sprite with its origin in the middle, scaled, rotated by angle degrees and moved to x,y
+    float rad = angle * 3.14159265f / 180;
+    float c = cos(rad), s = sin(rad);
+    float hw = frame.width * scale / 2, hh = frame.height * scale / 2;
+
+    const float cx[4] = {-hw, hw, hw, -hw};
+    const float cy[4] = {-hh, -hh, hh, hh};
+    const float u[4] = {(float) frame.left, (float) (frame.left + frame.width),
+                        (float) (frame.left + frame.width), (float) frame.left};
+    const float v[4] = {(float) frame.top, (float) frame.top,
+                        (float) (frame.top + frame.height), (float) (frame.top + frame.height)};
+
+    for (int i = 0; i < 4; i++)
+        va.append(Vertex(Vector2f(x + cx[i] * c - cy[i] * s, y + cx[i] * s + cy[i] * c), color, Vector2f(u[i], v[i])));
+}
+
+void Renderer::addCircle(float x, float y, float R) {
+    const int SIDES = 16;
+    Color red(255, 0, 0, 170);
+    for (int i = 0; i < SIDES; i++) {
+        float a0 = i * 2 * 3.14159265f / SIDES, a1 = (i + 1) * 2 * 3.14159265f / SIDES;
+        circles.append(Vertex(Vector2f(x, y), red));
+        circles.append(Vertex(Vector2f(x + R * cos(a0), y + R * sin(a0)), red));
+        circles.append(Vertex(Vector2f(x + R * cos(a1), y + R * sin(a1)), red));
+    }
+}
+
+Vector2f Renderer::blended(const EntityArray &e, size_t i, float alpha) const {
+    return Vector2f(blend(e.px[i], e.x[i], alpha, arena.x), blend(e.py[i], e.y[i], alpha, arena.y));
+}
+
+bool Renderer::inView(Vector2f &at, float reach) const {
+    if (arena.x > half.x * 2) at.x = nearest(at.x, centre.x, arena.x);
+    if (arena.y > half.y * 2) at.y = nearest(at.y, centre.y, arena.y);
+    return fabs(at.x - centre.x) < half.x + reach && fabs(at.y - centre.y) < half.y + reach;
+}
+
+void Renderer::draw(RenderTarget &app, const EntityStore &store, const Effects &effects, float alpha) {
+    drawCalls = 0;
+    culled = 0;
+    circles.clear();
+    centre = app.getView().getCenter();
+    half = app.getView().getSize() / 2.f;
+
+    RenderStates states(&atlas.texture);
+    for (int k = 0; k < KIND_COUNT; k++) {
+        const EntityArray &e = store.kinds[k];
+        VertexArray &va = layers[k];
+        va.clear();
+
+        for (size_t i = 0; i < e.size(); i++) {
+            const IntRect &frame = atlas.frames[e.clip[i]][int(e.frame[i])];
+            Vector2f at = blended(e, i, alpha);
+            if (!inView(at, (frame.width + frame.height) / 2.f)) { // further than a corner of the sprite reaches
+                culled++;
+                continue;
+            }
+            float angle = blendAngle(e.pangle[i], e.angle[i], alpha);
+            addSprite(va, frame, at.x, at.y, angle + 90);
+            if (showHitCircles) addCircle(at.x, at.y, e.R[i]);
+        }
+
+        if (va.getVertexCount()) {
+            app.draw(va, states);
+            drawCalls++;
+        }
+    }
+
+    // straight from the effect arrays into one vertex array. No blending from the tick before, each effect is
+    // drawn back along its own velocity instead
+    sparks.clear();
+    float back = (1 - alpha) * effects.step;
+    for (size_t i = 0; i < effects.slots(); i++) {
+        float life = effects.life[i];
+        if (life <= 0) continue;
+        Uint8 fade = life < 10 ? Uint8(life * 25.5f) : 255; // the last few frames fade out
+        const IntRect &frame = atlas.frames[effects.clip[i]][int(effects.frame[i])];
+        Vector2f at(effects.x[i] - effects.dx[i] * back, effects.y[i] - effects.dy[i] * back);
+        if (!inView(at, (frame.width + frame.height) * effects.scale[i] / 2)) {
+            culled++;
+            continue;
+        }
+        addSprite(sparks, frame, at.x, at.y, effects.angle[i] + 90, effects.scale[i], Color(255, 255, 255, fade));
+    }
+    if (sparks.getVertexCount()) {
+        app.draw(sparks, states);
+        drawCalls++;
+    }
+
+    if (circles.getVertexCount()) {
+        app.draw(circles);
+        drawCalls++;
+    }
+}
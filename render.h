@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - RENDERER
+// DESCRIPTION: Draws the world in a handful of draw calls. At startup every frame of every sprite sheet is
+// packed into one atlas texture. Each frame, every kind of entity becomes one vertex array of quads cut from
+// that atlas, drawn in a single call, and the effects go on top as one more. The hit circles are an optional
+// extra layer for debugging.
+// The simulation ticks at its own rate, so positions are blended between the last two ticks to match the
+// moment the frame is shown.
+// Only what the target's view can see goes into the vertex arrays. In an arena bigger than the view, which
+// wraps at its edges, everything is drawn at its copy nearest the middle of the view, so the camera can sit on
+// the seam.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_RENDER_H
+#define ASTEROIDS_RENDER_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+#include "assets.h"
+#include "world.h"
+
+class Atlas {
+public:
+    sf::Texture texture;
+    std::vector<sf::IntRect> frames[ANIM_COUNT]; // where each frame of each animation ended up in the atlas
+
+    bool build(Assets &assets); // packs the pictures of every clip, false if one is missing
+};
+
+class Renderer {
+public:
+    Atlas atlas;
+    bool showHitCircles; // red circle over every entity showing its collision radius
+    int drawCalls; // made by the last draw()
+    int culled; // entities and effects the last draw() left out, out of view
+    sf::Vector2f arena; // size of the world being drawn, W x H unless it scrolls
+
+    Renderer();
+
+    // alpha = how far the display is between the last two ticks, 0 = where things were before the last step()
+    void draw(sf::RenderTarget &app, const EntityStore &store, const Effects &effects, float alpha);
+
+    sf::Vector2f blended(const EntityArray &e, size_t i, float alpha) const; // where draw() puts entity i, for the camera
+
+private:
+    sf::VertexArray layers[KIND_COUNT]; // one per kind, drawn in Kind order
+    sf::VertexArray sparks; // every live effect
+    sf::VertexArray circles;
+
+    void addSprite(sf::VertexArray &va, const sf::IntRect &frame, float x, float y, float angle, float scale = 1,
+                   sf::Color color = sf::Color::White);
+    void addCircle(float x, float y, float R);
+    bool inView(sf::Vector2f &at, float reach) const; // moves at to its copy nearest the view, false if out of sight
+
+    sf::Vector2f centre, half; // of the view being drawn
+};
+
+#endif
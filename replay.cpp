@@ -0,0 +1,194 @@
+#include "replay.h"
+#include "fixed.h"
+
+namespace {
+
+const unsigned char VERSION = 4; // the arena size went into the header
+const int TAG_CHECK = 0x80;
+
+void putVarint(FILE *f, uint64_t v) { // 7 bits a byte, top bit set on all but the last
+    while (v >= 0x80) {
+        fputc((int) (v & 0x7f) | 0x80, f);
+        v >>= 7;
+    }
+    fputc((int) v, f);
+}
+
+bool getVarint(FILE *f, uint64_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(f);
+        if (c == EOF) return false;
+        v |= (uint64_t) (c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+void putLE(FILE *f, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        fputc((int) (v >> (8 * i)) & 0xff, f);
+}
+
+bool getLE(FILE *f, uint64_t &v, int bytes) {
+    v = 0;
+    for (int i = 0; i < bytes; i++) {
+        int c = fgetc(f);
+        if (c == EOF) return false;
+        v |= (uint64_t) c << (8 * i);
+    }
+    return true;
+}
+
+}
+
+unsigned char inputBits(const Input &in) {
+    return (in.left ? 1 : 0) | (in.right ? 2 : 0) | (in.thrust ? 4 : 0) | (in.fire ? 8 : 0);
+}
+
+Input inputFromBits(unsigned char bits) {
+    Input in;
+    in.left = bits & 1;
+    in.right = bits & 2;
+    in.thrust = bits & 4;
+    in.fire = bits & 8;
+    return in;
+}
+
+ReplayWriter::ReplayWriter() : f(0), every(60), bits(0), run(0) {}
+
+ReplayWriter::~ReplayWriter() {
+    close();
+}
+
+bool ReplayWriter::open(const char *path, const World &world, unsigned int seed, unsigned int hashEvery) {
+    close();
+    f = fopen(path, "wb");
+    if (!f) return false;
+
+    every = hashEvery ? hashEvery : 1;
+    bits = 0;
+    run = 0;
+
+    fwrite("ASTR", 1, 4, f);
+    fputc(VERSION, f);
+    putLE(f, seed, 4);
+    putLE(f, world.hz, 2);
+    putLE(f, every, 2);
+    fputc((world.continuous ? 1 : 0) | (FIXED_MATH ? 2 : 0), f);
+    fputc(world.across, f);
+    fputc(world.down, f);
+    writeCheck(world); // tick 0, catches a seed or hz mix-up before anything is played
+    return true;
+}
+
+void ReplayWriter::record(const Input &in, const World &world) {
+    if (!f) return;
+
+    unsigned char b = inputBits(in);
+    if (run && b != bits) endRun();
+    bits = b;
+    run++;
+
+    if (world.tick % every == 0) {
+        endRun(); // the check has to come right after the tick it is for
+        writeCheck(world);
+        fflush(f); // a crash still leaves everything up to here
+    }
+}
+
+void ReplayWriter::close() {
+    if (!f) return;
+    endRun();
+    fclose(f);
+    f = 0;
+}
+
+void ReplayWriter::endRun() {
+    if (!run) return;
+    fputc(bits, f);
+    putVarint(f, run);
+    run = 0;
+}
+
+void ReplayWriter::writeCheck(const World &world) {
+    fputc(TAG_CHECK, f);
+    putVarint(f, world.tick);
+    putLE(f, world.hash(), 8);
+}
+
+ReplayReader::ReplayReader() : seed(0), hz(60), hashEvery(60), continuous(false), across(1), down(1), checks(0),
+                               divergedAt(-1), f(0), bits(0), left(0) {}
+
+ReplayReader::~ReplayReader() {
+    if (f) fclose(f);
+}
+
+bool ReplayReader::open(const char *path) {
+    if (f) fclose(f);
+    f = fopen(path, "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint64_t s, h, e, flags, a, d;
+    if (fread(magic, 1, 4, f) != 4 || magic[0] != 'A' || magic[1] != 'S' || magic[2] != 'T' || magic[3] != 'R' ||
+        fgetc(f) != VERSION || !getLE(f, s, 4) || !getLE(f, h, 2) || !getLE(f, e, 2) ||
+        !getLE(f, flags, 1) || ((flags & 2) != 0) != FIXED_MATH || !getLE(f, a, 1) || !getLE(f, d, 1) || !a || !d ||
+        !supportedHz((int) h)) { // the game can't play it at any other rate
+        fclose(f);
+        f = 0;
+        return false;
+    }
+
+    seed = (unsigned int) s;
+    hz = (int) h;
+    hashEvery = (unsigned int) e;
+    continuous = flags & 1;
+    across = (int) a;
+    down = (int) d;
+    checks = 0;
+    divergedAt = -1;
+    left = 0;
+    return true;
+}
+
+bool ReplayReader::next(Input &in) {
+    while (f && left == 0) {
+        int tag = fgetc(f);
+        if (tag == EOF) return false;
+
+        uint64_t v, hash;
+        if (tag == TAG_CHECK) { // nobody asked, skip it
+            if (!getVarint(f, v) || !getLE(f, hash, 8)) return false;
+            continue;
+        }
+        if (!getVarint(f, v)) return false;
+        bits = (unsigned char) tag;
+        left = v;
+    }
+    if (!f) return false;
+
+    left--;
+    in = inputFromBits(bits);
+    return true;
+}
+
+bool ReplayReader::check(const World &world) {
+    if (divergedAt >= 0) return false;
+    if (!f || left) return true; // checks only ever come between runs
+
+    int tag = fgetc(f);
+    if (tag != TAG_CHECK) {
+        if (tag != EOF) ungetc(tag, f);
+        return true;
+    }
+
+    uint64_t tick, hash;
+    if (!getVarint(f, tick) || !getLE(f, hash, 8)) return true; // cut short, the game just ends here
+    if (tick != world.tick || hash != world.hash()) {
+        divergedAt = (long) world.tick;
+        return false;
+    }
+    checks++;
+    return true;
+}
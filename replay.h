@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - REPLAYS
+// DESCRIPTION: Records a game as its seed plus the keys held on every tick, and plays it back. The simulation
+// is deterministic, so that is all it takes to get the exact same game again, much faster than real time if
+// nothing is drawn. The file is written as a stream while the game goes on:
+//   header: "ASTR", version byte, seed (4 bytes), hz (2 bytes), hash interval (2 bytes), flags byte
+//           (bit 0 = swept collision, bit 1 = fixed point build, only a build with the same maths can play it),
+//           arena size in screens across and down (a byte each)
+//   then records, each starting with a tag byte:
+//     0x00-0x0F  a run of ticks with these input bits, the number of ticks follows as a varint
+//     0x80       hash check: the tick as a varint, then World::hash() after that tick (8 bytes)
+// Numbers are little endian. There is a check at tick 0 and then every interval ticks, so a replay that goes
+// a different way from the recording is caught within one interval.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_REPLAY_H
+#define ASTEROIDS_REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include "world.h"
+
+unsigned char inputBits(const Input &in); // left, right, thrust, fire as bits 0-3
+Input inputFromBits(unsigned char bits);
+
+class ReplayWriter {
+public:
+    ReplayWriter();
+    ~ReplayWriter(); // closes the file if it is still open
+
+    // starts a recording of world, which has to be fresh from World(seed, hz, across, down)
+    bool open(const char *path, const World &world, unsigned int seed, unsigned int hashEvery = 60);
+    void record(const Input &in, const World &world); // after every world.step(in)
+    void close();
+
+private:
+    FILE *f;
+    unsigned int every;
+    unsigned char bits; // input of the run being counted
+    unsigned long run; // ticks in it so far
+
+    void endRun();
+    void writeCheck(const World &world);
+
+    ReplayWriter(const ReplayWriter &);
+    ReplayWriter &operator=(const ReplayWriter &);
+};
+
+class ReplayReader {
+public:
+    unsigned int seed;
+    int hz;
+    unsigned int hashEvery;
+    bool continuous; // World::continuous of the recorded game
+    int across, down; // its arena
+
+    unsigned long checks; // hash checks passed
+    long divergedAt; // tick where the replay stopped matching the recording, -1 while it matches
+
+    ReplayReader();
+    ~ReplayReader();
+
+    bool open(const char *path); // reads the header, false if the file is missing or not a replay
+    bool next(Input &in); // input for the next tick, false when the recording ends
+    bool check(const World &world); // after every step (and once before the first), false once it has diverged
+
+private:
+    FILE *f;
+    unsigned char bits;
+    unsigned long left; // ticks left in the current run
+
+    ReplayReader(const ReplayReader &);
+    ReplayReader &operator=(const ReplayReader &);
+};
+
+#endif
@@ -0,0 +1,34 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - RANDOM NUMBERS
+// DESCRIPTION: A small random number generator (xorshift64*) that each World owns, in place of the global
+// rand(). Games no longer share one sequence, so any number of them can run side by side, on any thread, and
+// every one still plays out the same from its seed on any platform.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_RNG_H
+#define ASTEROIDS_RNG_H
+
+#include <cstdint>
+
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull; // splitmix64, so seeds 1, 2, 3 start far apart
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        state = (z ^ (z >> 31)) | 1; // never 0, xorshift would stay there
+    }
+
+    int next() { // 0 .. 2^31 - 1, used like rand()
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (int) ((state * 0x2545F4914F6CDD1Dull) >> 33);
+    }
+
+    uint64_t state;
+};
+
+#endif
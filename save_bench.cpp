@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SAVE/RESTORE BENCHMARK
+// DESCRIPTION: Builds a game with about 10k entities (extra rocks on top of level 1, played for a while so there
+// are bullets too), then times World::save() into one reused buffer and World::restore() from it.
+// Also checks the round trip: the hash right after a restore matches the one at the save, and playing on from a
+// restore, in the same world and in a different one, ends up with the same hash as playing on the first time.
+// USAGE: save_bench [entities] [ticks to play on]
+///////////////////////////////////////////////////
+
+#include "profile.h"
+#include "world.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+template<class F>
+double usPerCall(F call) { // runs call until a quarter of a second has gone by
+    call(); // warm up
+    long calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    do {
+        call();
+        calls++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.25);
+    return elapsed.count() * 1e6 / calls;
+}
+
+uint64_t playOn(World &world, unsigned long ticks) {
+    for (unsigned long i = 0; i < ticks; i++)
+        world.step(pilot(world.tick));
+    return world.hash();
+}
+
+int main(int argc, char **argv) {
+    size_t entities = argc > 1 ? strtoul(argv[1], 0, 10) : 10000;
+    unsigned long ticks = argc > 2 ? strtoul(argv[2], 0, 10) : 300;
+
+    World world(1);
+    world.spawnRocks((int) entities);
+    playOn(world, 60);
+    while (world.store.size() < entities) world.spawnRocks(1); // back up to the count after the shooting
+
+    std::vector<uint8_t> buffer;
+    world.save(buffer);
+    uint64_t saved = world.hash();
+
+    unsigned long allocsBefore = heapAllocations();
+    double saveUs = usPerCall([&world, &buffer]() { world.save(buffer); });
+    bool restored = true;
+    double restoreUs = usPerCall([&world, &buffer, &restored]() {
+        restored = world.restore(buffer.data(), buffer.size()) && restored;
+    });
+    unsigned long allocs = heapAllocations() - allocsBefore;
+
+    printf("%lu entities, %lu bytes (%.1f per entity)\n", (unsigned long) world.store.size(),
+           (unsigned long) buffer.size(), (double) buffer.size() / world.store.size());
+    printf("save    %8.2f us  %6.2f GB/s\n", saveUs, buffer.size() / saveUs / 1000);
+    printf("restore %8.2f us  %6.2f GB/s\n", restoreUs, buffer.size() / restoreUs / 1000);
+    printf("%lu heap allocations while saving and restoring\n", allocs);
+
+    bool ok = restored && world.hash() == saved;
+    uint64_t first = playOn(world, ticks);
+
+    ok = ok && world.restore(buffer.data(), buffer.size()) && world.hash() == saved;
+    uint64_t again = playOn(world, ticks);
+
+    World other(12345); // a different game entirely until the restore
+    ok = ok && other.restore(buffer.data(), buffer.size()) && other.hash() == saved;
+    uint64_t elsewhere = playOn(other, ticks);
+
+    printf("hash at save %016llx, after %lu more ticks %016llx / %016llx / %016llx\n", (unsigned long long) saved,
+           ticks, (unsigned long long) first, (unsigned long long) again, (unsigned long long) elsewhere);
+    if (!ok || first != again || first != elsewhere) {
+        printf("ROUND TRIP FAILED\n");
+        return 1;
+    }
+    printf("round trip ok\n");
+    return 0;
+}
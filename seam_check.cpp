@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SEAM CHECK
+// DESCRIPTION: A rock and a bullet touching across the seam of a scrolling arena small enough for the active
+// sectors to cover all of it, so the collision grid goes all the way round. One pair across the left/right
+// edge, one across the top/bottom and one across the corner, each in a fresh 2 x 2 screen arena, with discrete
+// and swept collision. Every pair has to be found on the first step. Exits 1 if any is missed.
+// USAGE: seam_check
+///////////////////////////////////////////////////
+
+#include "world.h"
+
+#include <cstdio>
+
+namespace {
+
+struct Pair {
+    const char *name;
+    float rockX, rockY, bulletX, bulletY; // in a 2400 x 1600 arena, 15 pixels apart round the edge
+};
+
+const Pair PAIRS[] = {
+        {"left/right", 2395, 800, 5, 800},
+        {"top/bottom", 600, 1595, 600, 5},
+        {"corner", 2395, 1595, 5, 5},
+};
+
+bool hits(const Pair &pair, bool continuous) {
+    World world(1, 60, 2, 2);
+    world.continuous = continuous;
+    EntityArray &a = world.store.kinds[KIND_ASTEROID];
+    for (size_t i = 0; i < a.size(); i++) // just the pair, nothing else to get in the way
+        a.life[i] = 0;
+    world.store.compact();
+    world.sectors.clear();
+    world.sectors.focus(world.cameraX, world.cameraY, W, H);
+
+    world.store.create(KIND_ASTEROID, pair.rockX, pair.rockY, 0, 25, ANIM_ROCK); // both sitting still
+    world.store.create(KIND_BULLET, pair.bulletX, pair.bulletY, 0, 10, ANIM_BULLET);
+    world.step(Input());
+    for (auto &e:world.events)
+        if (e.type == EV_ASTEROID_HIT) return true;
+    return false;
+}
+
+}
+
+int main() {
+    bool ok = true;
+    for (int swept = 0; swept < 2; swept++)
+        for (auto &pair:PAIRS) {
+            bool hit = hits(pair, swept != 0);
+            printf("%-10s %-8s %s\n", pair.name, swept ? "swept" : "discrete", hit ? "hit" : "MISSED");
+            ok = ok && hit;
+        }
+    printf(ok ? "every pair across the seam was found\n" : "pairs across the seam were missed\n");
+    return ok ? 0 : 1;
+}
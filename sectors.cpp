@@ -0,0 +1,125 @@
+#include "sectors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const int Sectors::SIZE;
+const int Sectors::FAR_FRAMES;
+
+namespace {
+
+int wrapIndex(int i, int n) {
+    i %= n;
+    return i < 0 ? i + n : i;
+}
+
+}
+
+void Sectors::resize(float width, float height) {
+    cols = std::max(1, (int) std::ceil(width / SIZE));
+    rows = std::max(1, (int) std::ceil(height / SIZE));
+    parked.resize(cols * rows);
+    for (auto &p:parked) // room for a level 5 wave's share and its splits before anything has to grow
+        p.reserve(16);
+    active.assign(cols * rows, 0);
+    window.clear();
+    entered.clear();
+    clear();
+}
+
+void Sectors::expect(size_t rocks) {
+    float share = (float) rocks / parked.size();
+    size_t room = std::max<size_t>(16, (size_t) (share + 6 * std::sqrt(share) + 8)); // six deviations out
+    for (auto &p:parked)
+        p.reserve(room);
+}
+
+void Sectors::focus(float cx, float cy, float w, float h) {
+    int i0 = (int) std::floor((cx - w / 2 - SIZE) / SIZE), i1 = (int) std::floor((cx + w / 2 + SIZE) / SIZE);
+    int j0 = (int) std::floor((cy - h / 2 - SIZE) / SIZE), j1 = (int) std::floor((cy + h / 2 + SIZE) / SIZE);
+    if (i1 - i0 >= cols) { // the view reaches all the way round
+        i0 = 0;
+        i1 = cols - 1;
+    }
+    if (j1 - j0 >= rows) {
+        j0 = 0;
+        j1 = rows - 1;
+    }
+    left = wrapIndex(i0, cols) * SIZE;
+    top = wrapIndex(j0, rows) * SIZE;
+    spanX = (i1 - i0 + 1) * SIZE;
+    spanY = (j1 - j0 + 1) * SIZE;
+
+    // only the old window is gone through, never the whole arena
+    previous.swap(window);
+    for (int s:previous)
+        active[s] = 2; // was active, back to 0 below unless it still is
+    window.clear();
+    entered.clear();
+    for (int j = j0; j <= j1; j++)
+        for (int i = i0; i <= i1; i++) {
+            int s = wrapIndex(j, rows) * cols + wrapIndex(i, cols);
+            if (active[s] == 1) continue; // already counted, the window has wrapped onto itself
+            if (active[s] == 0) entered.push_back(s);
+            active[s] = 1;
+            window.push_back(s);
+        }
+    for (int s:previous)
+        if (active[s] == 2) active[s] = 0;
+}
+
+size_t Sectors::parkedCount() const {
+    size_t n = 0;
+    for (auto &p:parked)
+        n += p.size();
+    return n;
+}
+
+void Sectors::clear() {
+    for (auto &p:parked)
+        p.clear();
+    for (int s:window)
+        active[s] = 0;
+    window.clear();
+    entered.clear();
+}
+
+size_t Sectors::saveBytes() const {
+    return parked.size() * sizeof(uint32_t) + parkedCount() * sizeof(Parked);
+}
+
+uint8_t *Sectors::save(uint8_t *out) const {
+    for (auto &p:parked) {
+        uint32_t n = p.size();
+        memcpy(out, &n, sizeof n);
+        memcpy(out + sizeof n, p.data(), n * sizeof(Parked));
+        out += sizeof n + n * sizeof(Parked);
+    }
+    return out;
+}
+
+bool Sectors::restore(const uint8_t *in, size_t n) {
+    clear();
+    const uint8_t *end = in + n;
+    bool ok = true;
+    for (size_t s = 0; s < parked.size() && ok; s++) {
+        uint32_t count;
+        ok = (size_t) (end - in) >= sizeof count;
+        if (!ok) break;
+        memcpy(&count, in, sizeof count);
+        in += sizeof count;
+        ok = (size_t) (end - in) >= count * sizeof(Parked);
+        if (!ok) break;
+
+        std::vector<Parked> &p = parked[s];
+        p.resize(count);
+        memcpy(p.data(), in, count * sizeof(Parked));
+        in += count * sizeof(Parked);
+        for (auto &r:p) // a bad clip means a damaged file
+            ok = ok && r.clip < ANIM_COUNT;
+    }
+    if (ok && in == end) return true; // every sector and nothing left over
+    clear();
+    return false;
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SECTORS
+// DESCRIPTION: How an arena bigger than the screen is kept cheap. The arena is cut into square sectors and the
+// ones within a sector of the camera's view are active: their rocks live in the entity store and get the full
+// step, moving, animating and colliding every tick. Every other sector's rocks are parked here, one flat array
+// per sector, and only moved a few sectors each tick in turn, by all the ticks since each was last moved. Nothing
+// out there can hit them (bullets and the ufo only live in active sectors), so nothing else needs doing. A rock
+// goes at most about 6 pixels a frame, so between turns it gets under 100 pixels from where its sector thinks it
+// is, well inside the sector of margin the camera keeps active round the screen.
+// As the camera moves, sectors coming into range stream their rocks into the store and rocks that end up in a
+// sector out of range are parked again, so the work of a tick goes with what is around the player, not with
+// how big the arena is.
+// The classic one screen game doesn't use any of this.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_SECTORS_H
+#define ASTEROIDS_SECTORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entities.h"
+
+struct Parked { // a rock in a sector away from the camera
+    float x, y, dx, dy, angle, R, frame;
+    uint8_t clip, pad[3]; // pad is 0, so the struct can be saved and hashed as it is
+    uint64_t tick; // the tick x, y are for
+};
+
+class Sectors {
+public:
+    static const int SIZE = 400; // sector width and height, a screen is 3 x 2 of them
+    static const int FAR_FRAMES = 16; // a parked sector is moved once every this many 60 Hz frames
+
+    int cols, rows;
+    std::vector<std::vector<Parked> > parked; // rocks of the sectors that aren't active
+    std::vector<unsigned char> active; // 1 = near the camera, its rocks are in the entity store
+    std::vector<int> window; // the active sectors, in the order they stream in
+    std::vector<int> entered; // sectors that became active on the last focus()
+    float left, top, spanX, spanY; // the active sectors' top left corner in the arena and their size
+
+    Sectors() : cols(0), rows(0), left(0), top(0), spanX(0), spanY(0) {}
+
+    void resize(float width, float height); // sectors for an arena of this size, all empty and none active
+    // room in every sector for its share of this many rocks plus the most they bunch up drifting about, so a
+    // sector never has to grow in the middle of the game
+    void expect(size_t rocks);
+
+    int of(float x, float y) const { // sector x, y is in, anything on or past an edge goes in the edge sector
+        int i = int(x / SIZE), j = int(y / SIZE);
+        if (x < 0) i = 0;
+        if (i >= cols) i = cols - 1;
+        if (y < 0) j = 0;
+        if (j >= rows) j = rows - 1;
+        return j * cols + i;
+    }
+
+    bool near(float x, float y) const { return active[of(x, y)] != 0; }
+
+    // the camera is looking at a view x w x h centred on cx, cy: makes every sector that view reaches, plus a
+    // sector all round, active (wrapping round the arena's edges) and lists the ones that weren't
+    void focus(float cx, float cy, float w, float h);
+
+    size_t parkedCount() const;
+    void clear(); // no parked rocks and none active, the arrays keep their capacity
+
+    // parked rocks for World::save(), the active set isn't saved, the next focus() works it out
+    size_t saveBytes() const;
+    uint8_t *save(uint8_t *out) const;
+    bool restore(const uint8_t *in, size_t n); // false if it isn't exactly this arena's sectors
+
+private:
+    std::vector<int> previous; // scratch for focus()
+};
+
+#endif
@@ -0,0 +1,308 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "world.h"
+
+namespace {
+
+enum { // field mask bits, the ones that change every tick first so the usual mask is one byte
+    F_X = 1,
+    F_Y = 2,
+    F_FRAME = 4,
+    F_ANGLE = 8,
+    F_R = 16,
+    F_CLIP = 32,
+    F_NEW = 64, // not in the base, generation and kind follow
+    F_VX = 128,
+    F_VY = 256,
+    F_VFRAME = 512
+};
+
+const NetEntity NONE = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; // what a new entity's fields are the difference from
+const std::vector<NetEntity> EMPTY;
+
+void putVarint(std::vector<uint8_t> &out, uint64_t v) { // same as in replay files
+    while (v >= 0x80) {
+        out.push_back((uint8_t) ((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t) v);
+}
+
+uint32_t zigzag(int32_t v) { return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31); } // small either side of 0 = few bytes
+int32_t unzigzag(uint32_t v) { return (int32_t) (v >> 1) ^ -(int32_t) (v & 1); }
+
+void putDiff(std::vector<uint8_t> &out, uint16_t cur, uint16_t base) { // signed fields go through as uint16 too
+    putVarint(out, zigzag((int16_t) (uint16_t) (cur - base))); // wraps, the shorter way round is always taken
+}
+
+struct Reader {
+    const uint8_t *p, *end;
+    bool ok;
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) break;
+            uint8_t c = *p++;
+            v |= (uint64_t) (c & 0x7f) << shift;
+            if (!(c & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+
+    void diff(uint16_t &field) { field = (uint16_t) (field + unzigzag((uint32_t) varint())); }
+    void diff(int16_t &field) { field = (int16_t) (uint16_t) (field + unzigzag((uint32_t) varint())); }
+
+    long slot(long prev) { // next slot of a gap list, -1 at the end of it
+        uint64_t gap = varint();
+        if (!gap) return -1;
+        long s = prev + (long) gap;
+        if (s > 0xffff) ok = false;
+        return s;
+    }
+};
+
+uint16_t fixed(float v, float scale, float offset) { // clamped into 16 bits
+    long q = lround((v + offset) * scale);
+    return (uint16_t) std::max(0L, std::min(q, 0xffffL));
+}
+
+uint16_t cursor(float frame, int clip) { // 1/256ths of a frame, rounded down so it can't land on the clip's end
+    long q = (long) std::floor(frame * 256);
+    return (uint16_t) std::max(0L, std::min(q, CLIPS[clip].count * 256l - 1));
+}
+
+unsigned mask(const NetEntity &c, const NetEntity &b) {
+    return (c.x != b.x ? F_X : 0) | (c.y != b.y ? F_Y : 0) | (c.frame != b.frame ? F_FRAME : 0) |
+           (c.angle != b.angle ? F_ANGLE : 0) | (c.R != b.R ? F_R : 0) | (c.clip != b.clip ? F_CLIP : 0) |
+           (c.vx != b.vx ? F_VX : 0) | (c.vy != b.vy ? F_VY : 0) | (c.vframe != b.vframe ? F_VFRAME : 0);
+}
+
+int16_t rate(float v) { // per tick, clamped into 16 bits signed
+    long q = lround(v);
+    return (int16_t) std::max(-0x8000L, std::min(q, 0x7fffL));
+}
+
+bool bySlot(const NetEntity &a, const NetEntity &b) { return a.slot < b.slot; }
+
+long moved(long rate, unsigned long ticks) { // rate * ticks / 16 rounded, the same on every compiler
+    long d = rate * (long) ticks;
+    return d >= 0 ? (d + 8) / 16 : -((8 - d) / 16);
+}
+
+}
+
+NetEntity predict(const NetEntity &e, unsigned long ticks) {
+    NetEntity p = e; // integer maths only, both ends have to get exactly the same answer
+    p.x = (uint16_t) (e.x + moved(e.vx, ticks));
+    p.y = (uint16_t) (e.y + moved(e.vy, ticks));
+    p.frame = (uint16_t) ((e.frame + moved(e.vframe, ticks)) % (CLIPS[e.clip].count * 256l));
+    return p;
+}
+
+float netX(uint16_t q) { return q / 8.0f - 64; }
+float netAngle(uint16_t q) { return q * (360.0f / 65536); }
+
+void takeSnapshot(const World &world, Snapshot &out) {
+    out.tick = world.tick;
+    out.score = world.score;
+    out.level = world.level;
+    out.lives = world.lives;
+    out.entities.clear();
+
+    for (int k = 0; k < KIND_COUNT; k++) {
+        const EntityArray &a = world.store.kinds[k];
+        for (size_t i = 0; i < a.size(); i++) {
+            Handle h = world.store.handle(k, i);
+            float angle = std::fmod(a.angle[i], 360.0f);
+            if (angle < 0) angle += 360;
+
+            NetEntity e;
+            e.slot = (uint16_t) h.slot; // the game has a few hundred entities at most
+            e.generation = (uint16_t) h.generation;
+            e.kind = (uint8_t) k;
+            e.clip = a.clip[i];
+            e.x = fixed(a.x[i], 8, 64);
+            e.y = fixed(a.y[i], 8, 64);
+            e.angle = (uint16_t) (lround(angle * (65536 / 360.0f)) & 0xffff);
+            e.R = fixed(a.R[i], 256, 0);
+            e.frame = cursor(a.frame[i], a.clip[i]);
+            e.vx = rate(a.dx[i] * world.dt * 128);
+            e.vy = rate(a.dy[i] * world.dt * 128);
+            e.vframe = (uint16_t) rate(a.speed[i] * world.dt * 4096);
+            out.entities.push_back(e);
+        }
+    }
+    std::sort(out.entities.begin(), out.entities.end(), bySlot);
+}
+
+void encodeSnapshot(const Snapshot *base, const Snapshot &cur, std::vector<uint8_t> &out) {
+    out.clear();
+    putVarint(out, cur.tick);
+    putVarint(out, base ? cur.tick - base->tick : 0);
+    putVarint(out, cur.score);
+    putVarint(out, cur.level);
+    putVarint(out, zigzag(cur.lives));
+
+    const std::vector<NetEntity> &b = base ? base->entities : EMPTY, &c = cur.entities;
+
+    long prev = -1; // removed: in the base but not here, or here with another generation
+    for (size_t i = 0, j = 0; i < b.size(); i++) {
+        while (j < c.size() && c[j].slot < b[i].slot) j++;
+        if (j < c.size() && c[j].slot == b[i].slot && c[j].generation == b[i].generation) continue;
+        putVarint(out, b[i].slot - prev);
+        prev = b[i].slot;
+    }
+    putVarint(out, 0);
+
+    unsigned long back = base ? cur.tick - base->tick : 0;
+    prev = -1; // changed: new, or something other than what its rates said would happen
+    for (size_t j = 0, i = 0; j < c.size(); j++) {
+        while (i < b.size() && b[i].slot < c[j].slot) i++;
+        bool existing = i < b.size() && b[i].slot == c[j].slot && b[i].generation == c[j].generation;
+        NetEntity from = existing ? predict(b[i], back) : NONE;
+        unsigned m = mask(c[j], from) | (existing ? 0 : F_NEW);
+        if (!m) continue;
+
+        putVarint(out, c[j].slot - prev);
+        prev = c[j].slot;
+        putVarint(out, m);
+        if (m & F_NEW) {
+            putVarint(out, c[j].generation);
+            out.push_back(c[j].kind);
+        }
+        if (m & F_X) putDiff(out, c[j].x, from.x);
+        if (m & F_Y) putDiff(out, c[j].y, from.y);
+        if (m & F_FRAME) putDiff(out, c[j].frame, from.frame);
+        if (m & F_ANGLE) putDiff(out, c[j].angle, from.angle);
+        if (m & F_R) putDiff(out, c[j].R, from.R);
+        if (m & F_CLIP) putVarint(out, zigzag(c[j].clip - from.clip));
+        if (m & F_VX) putDiff(out, c[j].vx, from.vx);
+        if (m & F_VY) putDiff(out, c[j].vy, from.vy);
+        if (m & F_VFRAME) putDiff(out, c[j].vframe, from.vframe);
+    }
+    putVarint(out, 0);
+}
+
+bool snapshotBase(const uint8_t *data, size_t n, unsigned long &tick, unsigned long &back) {
+    Reader r = {data, data + n, true};
+    tick = (unsigned long) r.varint();
+    back = (unsigned long) r.varint();
+    return r.ok && back <= tick;
+}
+
+bool decodeSnapshot(const Snapshot *base, const uint8_t *data, size_t n, Snapshot &out) {
+    Reader r = {data, data + n, true};
+    unsigned long tick = (unsigned long) r.varint(), back = (unsigned long) r.varint();
+    out.score = (unsigned int) r.varint();
+    out.level = (int) r.varint();
+    out.lives = unzigzag((uint32_t) r.varint());
+    if (!r.ok || !tick) return false;
+    if (!back) base = 0;
+    else if (!base || base->tick + back != tick) return false;
+    out.tick = tick;
+
+    // the removed list is read alongside the changes by a second reader, so the base can be copied across in
+    // one pass with nothing to hold the list in
+    Reader removedList = r;
+    while (r.ok && r.slot(-1) != -1) {}
+    long removed = removedList.slot(-1);
+
+    const std::vector<NetEntity> &b = base ? base->entities : EMPTY;
+    out.entities.clear();
+    size_t i = 0;
+    long prev = -1;
+    while (r.ok) {
+        long s = r.slot(prev);
+        long upTo = s < 0 ? 0x10000 : s; // copy everything left in the base at the end
+        while (i < b.size() && b[i].slot < upTo) {
+            if (b[i].slot == removed) removed = removedList.slot(removed);
+            else out.entities.push_back(predict(b[i], back)); // not mentioned = went the way its rates said
+            i++;
+        }
+        if (s < 0 || !r.ok) break;
+        prev = s;
+
+        bool existing = i < b.size() && b[i].slot == s;
+        if (existing && removed == s) { // its slot went to something new
+            removed = removedList.slot(removed);
+            existing = false;
+            i++;
+        }
+
+        unsigned m = (unsigned) r.varint();
+        NetEntity e;
+        if (m & F_NEW) {
+            if (existing) return false;
+            e = NONE;
+            e.slot = (uint16_t) s;
+            e.generation = (uint16_t) r.varint();
+            e.kind = r.byte();
+        } else {
+            if (!existing) return false;
+            e = predict(b[i++], back);
+        }
+        if (m & F_X) r.diff(e.x);
+        if (m & F_Y) r.diff(e.y);
+        if (m & F_FRAME) r.diff(e.frame);
+        if (m & F_ANGLE) r.diff(e.angle);
+        if (m & F_R) r.diff(e.R);
+        if (m & F_CLIP) e.clip = (uint8_t) (e.clip + unzigzag((uint32_t) r.varint()));
+        if (m & F_VX) r.diff(e.vx);
+        if (m & F_VY) r.diff(e.vy);
+        if (m & F_VFRAME) r.diff(e.vframe);
+        if (e.kind >= KIND_COUNT || e.clip >= ANIM_COUNT || e.frame >= CLIPS[e.clip].count * 256) return false;
+        out.entities.push_back(e);
+    }
+    // everything removed has to have been in the base, and nothing can be left over
+    return r.ok && removedList.ok && removed == -1 && r.p == r.end;
+}
+
+bool sameSnapshot(const Snapshot &a, const Snapshot &b) {
+    if (a.tick != b.tick || a.score != b.score || a.level != b.level || a.lives != b.lives ||
+        a.entities.size() != b.entities.size())
+        return false;
+    for (size_t i = 0; i < a.entities.size(); i++) {
+        const NetEntity &p = a.entities[i], &q = b.entities[i];
+        if (p.slot != q.slot || p.generation != q.generation || p.kind != q.kind || p.clip != q.clip ||
+            p.x != q.x || p.y != q.y || p.angle != q.angle || p.R != q.R || p.frame != q.frame || p.vx != q.vx ||
+            p.vy != q.vy || p.vframe != q.vframe)
+            return false;
+    }
+    return true;
+}
+
+void applySnapshot(const Snapshot *prev, const Snapshot &cur, EntityStore &store) {
+    store.clear();
+    const std::vector<NetEntity> &b = prev ? prev->entities : EMPTY;
+    size_t j = 0;
+    for (auto &e:cur.entities) {
+        float x = netX(e.x), y = netX(e.y), angle = netAngle(e.angle);
+        Handle h = store.create(e.kind, x, y, angle, e.R / 256.0f, e.clip);
+        EntityArray &a = store.kinds[e.kind];
+        int i = store.find(h).index;
+        a.frame[i] = e.frame / 256.0f;
+
+        while (j < b.size() && b[j].slot < e.slot) j++;
+        if (j < b.size() && b[j].slot == e.slot && b[j].generation == e.generation) {
+            a.px[i] = netX(b[j].x);
+            a.py[i] = netX(b[j].y);
+            float from = netAngle(b[j].angle); // the short way round, 350 to 10 is 20 degrees
+            if (from - angle > 180) from -= 360;
+            if (angle - from > 180) from += 360;
+            a.pangle[i] = from;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - NETWORK SNAPSHOTS
+// DESCRIPTION: What the server sends its clients after every tick: every entity's position, angle, radius and
+// animation frame squeezed into 16-bit fixed point, plus the score, level and lives. A snapshot goes out as a
+// delta against the last one the client said it has (its ack). Each entity also carries how far it moves and
+// animates per tick, and both ends move the base's entities on by that many ticks before comparing, so a rock
+// drifting in a straight line costs nothing and only what steered, wrapped or sped up is sent. With no ack yet
+// the delta is against nothing, a full snapshot.
+// Entities are matched between snapshots by handle slot and generation. Encoded layout, varints throughout:
+//   tick, ticks back to the base (0 = none), score, level, lives
+//   removed: slot gap + 1 for each entity of the base that is gone, then 0
+//   changed: slot gap + 1, field mask, [generation, kind if new], each field in the mask as the zigzag
+//            difference from the moved on base (from 0 if new), then 0
+// Snapshots are kept in rings so either end can find the base a delta refers to.
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_SNAPSHOT_H
+#define ASTEROIDS_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entities.h"
+
+class World;
+
+struct NetEntity {
+    uint16_t slot, generation; // its handle, cut to 16 bits
+    uint8_t kind, clip;
+    uint16_t x, y; // 1/8 pixel, from -64
+    uint16_t angle; // 1/65536 of a turn
+    uint16_t R, frame; // 8.8 fixed point
+    int16_t vx, vy; // per tick, 1/16 of the units of x, y so the rounding doesn't add up over a few ticks
+    uint16_t vframe; // per tick, 1/16 of the units of frame
+};
+
+struct Snapshot {
+    unsigned long tick; // 0 = empty, no tick has been stored here
+    unsigned int score;
+    int level, lives;
+    std::vector<NetEntity> entities; // in slot order
+
+    Snapshot() : tick(0), score(0), level(0), lives(0) {}
+};
+
+void takeSnapshot(const World &world, Snapshot &out); // quantized copy of the world as it is now
+
+// base = 0 for a full snapshot. out is cleared first and keeps its capacity
+void encodeSnapshot(const Snapshot *base, const Snapshot &cur, std::vector<uint8_t> &out);
+
+// ticks back to the base that data was encoded against, 0 for a full one, so the caller can look the base up
+bool snapshotBase(const uint8_t *data, size_t n, unsigned long &tick, unsigned long &back);
+
+// false if data is cut short, garbled or doesn't fit base
+bool decodeSnapshot(const Snapshot *base, const uint8_t *data, size_t n, Snapshot &out);
+
+bool sameSnapshot(const Snapshot &a, const Snapshot &b);
+
+// rebuilds store from a snapshot for drawing. Entities that were also in prev blend from where they were in it
+void applySnapshot(const Snapshot *prev, const Snapshot &cur, EntityStore &store);
+
+NetEntity predict(const NetEntity &e, unsigned long ticks); // e moved on by ticks at its rates
+
+float netX(uint16_t q); // back from fixed point
+float netAngle(uint16_t q);
+
+class SnapshotRing { // the last few snapshots by tick
+public:
+    explicit SnapshotRing(size_t n = 64) : slots(n) {}
+
+    Snapshot &slot(unsigned long tick) { return slots[tick % slots.size()]; } // to store tick in
+    const Snapshot *find(unsigned long tick) const { // 0 once it has been overwritten
+        const Snapshot &s = slots[tick % slots.size()];
+        return tick && s.tick == tick ? &s : 0;
+    }
+
+private:
+    std::vector<Snapshot> slots;
+};
+
+#endif
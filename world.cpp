@@ -0,0 +1,869 @@
+#include "world.h"
+#include "fixed.h"
+#include "profile.h"
+#include "integrate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+
+// entities per job when the step is split across threads. Fixed, so the work is cut up the same way (and the
+// results merged in the same order) whatever the thread count
+const size_t CHUNK = 1024;
+
+struct TickRate {
+    int hz;
+    int64_t drag; // the ship's drag of 0.99 per 60 Hz frame, per tick as a fraction of 65536 (for fixed point)
+};
+
+const TickRate RATES[] = {{30, 64232}, {60, 64881}, {120, 65207}, {240, 65372}};
+
+bool supportedHz(int hz) {
+    for (auto &r:RATES)
+        if (r.hz == hz) return true;
+    return false;
+}
+
+static void advance(float *x, float *y, const float *dx, const float *dy, size_t n, float dt) {
+#if ASTEROIDS_FIXED
+    integrateFixed(x, y, dx, dy, n, dt);
+#else
+    integrate(x, y, dx, dy, n, dt);
+#endif
+}
+
+void moveUfos(EntityArray &u, size_t begin, size_t end, float dt, float w, float h, bool wrapAround) {
+    advance(&u.x[begin], &u.y[begin], &u.dx[begin], &u.dy[begin], end - begin, dt);
+    if (wrapAround) wrap(&u.x[begin], &u.y[begin], end - begin, w, h);
+    else cull(&u.x[begin], &u.y[begin], &u.life[begin], end - begin, w, h); // gone once it has crossed the screen
+}
+
+void moveAsteroids(EntityArray &a, size_t begin, size_t end, float dt, float w, float h) {
+    advance(&a.x[begin], &a.y[begin], &a.dx[begin], &a.dy[begin], end - begin, dt); // change position by dx and dy
+    wrap(&a.x[begin], &a.y[begin], end - begin, w, h); // wrap around to other side of screen
+}
+
+void moveBullets(EntityArray &b, size_t begin, size_t end, float dt, float w, float h, bool wrapAround) { // bullets fly in a straight line, their dx/dy are set once when fired
+    advance(&b.x[begin], &b.y[begin], &b.dx[begin], &b.dy[begin], end - begin, dt);
+    if (wrapAround) wrap(&b.x[begin], &b.y[begin], end - begin, w, h);
+    else cull(&b.x[begin], &b.y[begin], &b.life[begin], end - begin, w, h); // disappear if falls off screen
+}
+
+#if ASTEROIDS_FIXED
+
+void movePlayers(EntityArray &p, size_t begin, size_t end, bool thrust, float dt, float w, float h) {
+    // the same as below in 1/256 pixels: thrust of 51/256 (about 0.2) per frame, drag from RATES for the tick
+    // length the game runs at (World only takes the rates in there), speed capped at 15
+    int64_t t = toFix(dt), drag = RATES[1].drag;
+    for (auto &r:RATES)
+        if (t == 60 * FIX_ONE / r.hz) drag = r.drag;
+    const int64_t maxSpeed = 15 * FIX_ONE;
+
+    for (size_t i = begin; i < end; i++) {
+        int64_t dx = toFix(p.dx[i]), dy = toFix(p.dy[i]);
+        if (thrust) {
+            dx += fixCos(p.angle[i]) * 51 * t / (65536 * FIX_ONE);
+            dy += fixSin(p.angle[i]) * 51 * t / (65536 * FIX_ONE);
+        } else {
+            dx = dx * drag / 65536;
+            dy = dy * drag / 65536;
+        }
+
+        uint64_t speed2 = dx * dx + dy * dy;
+        if (speed2 > (uint64_t) (maxSpeed * maxSpeed)) {
+            int64_t speed = isqrt(speed2);
+            dx = dx * maxSpeed / speed;
+            dy = dy * maxSpeed / speed;
+        }
+        p.dx[i] = fromFix(dx);
+        p.dy[i] = fromFix(dy);
+    }
+
+    advance(&p.x[begin], &p.y[begin], &p.dx[begin], &p.dy[begin], end - begin, dt);
+    wrap(&p.x[begin], &p.y[begin], end - begin, w, h);
+}
+
+#else
+
+void movePlayers(EntityArray &p, size_t begin, size_t end, bool thrust, float dt, float w, float h) {
+    double drag = pow(0.99, dt); // 0.99 per 60 Hz frame however many ticks that is split into
+    for (size_t i = begin; i < end; i++) {
+        float &dx = p.dx[i], &dy = p.dy[i];
+
+        if (thrust) { // trust is for the effect of making the ship speed up and slow down depending on if the up key is being pressed
+            dx += cos(p.angle[i] * DEGTORAD) * 0.2 * dt;
+            dy += sin(p.angle[i] * DEGTORAD) * 0.2 * dt;
+        } else {
+            dx *= drag;
+            dy *= drag;
+        }
+
+        int maxSpeed = 15;
+        float speed = sqrt(dx * dx + dy * dy);
+        if (speed > maxSpeed) {
+            dx *= maxSpeed / speed;
+            dy *= maxSpeed / speed;
+        }
+    }
+
+    integrate(&p.x[begin], &p.y[begin], &p.dx[begin], &p.dy[begin], end - begin, dt); // updating positon by dy and dx
+    wrap(&p.x[begin], &p.y[begin], end - begin, w, h); // wrap around screen
+}
+
+#endif
+
+void animate(EntityArray &e, size_t begin, size_t end, float dt) {
+    for (size_t i = begin; i < end; i++) {
+        int n = CLIPS[e.clip[i]].count;
+        e.frame[i] += e.speed[i] * dt; // changes frame for each speed increment
+        if (e.frame[i] >= n) e.frame[i] -= n;
+    }
+}
+
+
+bool isCollide(const EntityArray &A, int a, const EntityArray &B, int b, float sx, float sy) {
+    float ax = A.x[a] + sx, ay = A.y[a] + sy;
+#if ASTEROIDS_FIXED
+    int64_t dx = toFix(B.x[b]) - toFix(ax), dy = toFix(B.y[b]) - toFix(ay), R = toFix(A.R[a]) + toFix(B.R[b]);
+    return dx * dx + dy * dy < R * R;
+#else
+    return (B.x[b] - ax) * (B.x[b] - ax) +
+           (B.y[b] - ay) * (B.y[b] - ay) <
+           (A.R[a] + B.R[b]) * (A.R[a] + B.R[b]);
+#endif
+}
+
+static float shift(float from, float to, float edge) { // how far to move from to get the copy of it nearest to
+    if (to - from > edge / 2) return edge;
+    if (from - to > edge / 2) return -edge;
+    return 0;
+}
+
+static float unwrap(float from, float to, float edge) { // from, moved to the same side of the seam as to
+    if (to - from > edge / 2) return from + edge;
+    if (from - to > edge / 2) return from - edge;
+    return from;
+}
+
+static float moved(const EntityArray &e, size_t i, float w, float h) {
+    float mx = e.x[i] - unwrap(e.px[i], e.x[i], w), my = e.y[i] - unwrap(e.py[i], e.y[i], h);
+#if ASTEROIDS_FIXED
+    int64_t qx = toFix(mx), qy = toFix(my);
+    return fromFix(isqrt(qx * qx + qy * qy) + 1); // rounded up, this is how far to reach
+#else
+    return sqrt(mx * mx + my * my);
+#endif
+}
+
+bool sweptCollide(const EntityArray &A, int a, const EntityArray &B, int b, float sx, float sy, float w, float h) {
+    // work in b's frame: a goes from d0 to d1 relative to b, did it come within R of it on the way
+    float ax0 = unwrap(A.px[a], A.x[a], w) + sx, ay0 = unwrap(A.py[a], A.y[a], h) + sy;
+    float bx0 = unwrap(B.px[b], B.x[b], w), by0 = unwrap(B.py[b], B.y[b], h);
+    float d0x = ax0 - bx0, d0y = ay0 - by0;
+    float vx = (A.x[a] + sx - B.x[b]) - d0x, vy = (A.y[a] + sy - B.y[b]) - d0y;
+    float R = A.R[a] + B.R[b];
+
+#if ASTEROIDS_FIXED // the same test in 1/256ths, with the square root squared away
+    int64_t dx = toFix(d0x), dy = toFix(d0y), ux = toFix(vx), uy = toFix(vy), r = toFix(R);
+    int64_t c = dx * dx + dy * dy - r * r;
+    if (c < 0) return true;
+    int64_t bq = dx * ux + dy * uy;
+    if (bq >= 0) return false;
+    int64_t aq = ux * ux + uy * uy;
+    if (-bq - aq < 0) return !lessProduct(-bq, -bq, aq, c); // touches before the end as long as it touches at all
+    return 2 * bq + aq + c < 0; // (-bq - aq)^2 < bq^2 - aq * c, expanded
+#else
+    float c = d0x * d0x + d0y * d0y - R * R;
+    if (c < 0) return true; // touching from the start
+    float bq = d0x * vx + d0y * vy;
+    if (bq >= 0) return false; // not getting any closer
+    float aq = vx * vx + vy * vy;
+    float disc = bq * bq - aq * c;
+    if (disc < 0) return false; // closest approach is still too far
+    return -bq - sqrt(disc) < aq; // first touch at t = (-bq - sqrt(disc)) / aq, before the end of the tick
+#endif
+}
+
+Input pilot(unsigned long tick, int hz) {
+    Input in;
+    in.right = true;
+    in.fire = tick % (8 * hz / 60) == 0;
+    in.thrust = tick % (120 * hz / 60) < 30 * (unsigned long) hz / 60;
+    return in;
+}
+
+World::World(unsigned int seed, int hz, int across, int down) :
+        hz(hz), dt(60.0f / hz), across(across), down(down), width(W * across), height(H * down), rng(seed),
+        grid(50) { // cells as wide as a big rock
+    jobs = 0;
+    continuous = false;
+    slack = 0;
+
+    // pools sized for the worst the game throws at us: 45 rocks on level 5 that can all split in two and one
+    // bullet a frame living ~240 frames to cross the screen. A scrolling arena has the same density of rocks and
+    // keeps about five screens of them in the store
+    store.reserve(KIND_ASTEROID, scrolling() ? 5 * 256 : 256);
+    store.reserve(KIND_UFO, 4);
+    store.reserve(KIND_BULLET, 256);
+    store.reserve(KIND_PLAYER, 1);
+    events.reserve(64);
+    if (scrolling()) sectors.resize(width, height);
+
+    reset(seed);
+}
+
+void World::reset(unsigned int seed) {
+    store.clear();
+    effects.clear();
+    effects.reseed(~(uint64_t) seed);
+    commands.clear();
+    events.clear();
+    rng.reseed(seed);
+
+    thrust = false;
+    score = 0;
+    level = 1;
+    lives = 3;
+    tick = 0;
+
+    cameraX = W / 2;
+    cameraY = H / 2;
+    if (scrolling()) { // on where the ship starts, so the first wave knows which rocks to park
+        cameraX = cameraY = 200;
+        sectors.clear();
+        sectors.focus(cameraX, cameraY, W, H);
+    }
+
+    spawnRocks(15 * across * down);
+
+    p = add(KIND_PLAYER, 200, 200, 0, 20, ANIM_PLAYER);
+}
+
+Handle World::add(int kind, float x, float y, float angle, float radius, int clip) {
+    return store.create(kind, x, y, angle, radius, clip);
+}
+
+Handle World::addAsteroid(float x, float y, float angle, float radius, int clip) {
+    float dx = rng.next() % 8 - 4; // change in position
+    float dy = rng.next() % 8 - 4;
+
+    Handle h = add(KIND_ASTEROID, x, y, angle, radius, clip);
+    int i = store.find(h).index;
+    store.kinds[KIND_ASTEROID].dx[i] = dx;
+    store.kinds[KIND_ASTEROID].dy[i] = dy;
+    return h;
+}
+
+void World::park(float x, float y, float dx, float dy, float angle, float radius, int clip, float frame,
+                 unsigned long now) {
+    Parked r = {x, y, dx, dy, angle, radius, frame, (uint8_t) clip, {0, 0, 0}, now};
+    sectors.parked[sectors.of(x, y)].push_back(r);
+}
+
+void World::catchUp(Parked &r, unsigned long now) const {
+#if ASTEROIDS_FIXED
+    int64_t t = toFix(dt) * (int64_t) (now - r.tick);
+    r.x = fromFix(toFix(r.x) + toFix(r.dx) * t / FIX_ONE);
+    r.y = fromFix(toFix(r.y) + toFix(r.dy) * t / FIX_ONE);
+#else
+    float t = (now - r.tick) * dt;
+    r.x += r.dx * t;
+    r.y += r.dy * t;
+#endif
+    wrapScalar(&r.x, &r.y, 1, width, height);
+    r.tick = now;
+}
+
+void World::spawnRocks(int n) {
+    if (scrolling()) sectors.expect(sectors.parkedCount() + store.kinds[KIND_ASTEROID].size() + n);
+    for (int i = 0; i < n; i++) {
+        float x = rng.next() % width, y = rng.next() % height, angle = rng.next() % 360;
+        if (!scrolling() || sectors.near(x, y)) {
+            addAsteroid(x, y, angle, 25, ANIM_ROCK);
+            continue;
+        }
+        float dx = rng.next() % 8 - 4; // the same as addAsteroid()
+        float dy = rng.next() % 8 - 4;
+        park(x, y, dx, dy, angle, 25, ANIM_ROCK, 0, tick);
+    }
+}
+
+void World::playerHit(Ref a, unsigned int penalty) {
+    commands.score(-(int) penalty); // points lost for crashing into something, down to 0
+    commands.event(EV_SCORE, 0, 0);
+
+    EntityArray &pl = store.kinds[a.kind];
+    commands.event(EV_PLAYER_HIT, pl.x[a.index], pl.y[a.index]);
+    commands.respawn(a); // resets player to the center of screen ****** LIFE CODE *******
+    commands.lives(-1);
+}
+
+void World::respawn(Ref r) {
+    EntityArray &pl = store.kinds[r.kind];
+    int i = r.index;
+    pl.x[i] = width / 2;
+    pl.y[i] = height / 2;
+    pl.angle[i] = 0;
+    pl.dx[i] = 0;
+    pl.dy[i] = 0;
+    pl.px[i] = pl.x[i]; // a jump, not something to slide across the screen
+    pl.py[i] = pl.y[i];
+    pl.pangle[i] = 0;
+    pl.clip[i] = ANIM_PLAYER;
+    pl.frame[i] = 0;
+}
+
+void World::event(int type, float x, float y, Handle entity) {
+    WorldEvent e = {type, x, y, entity};
+    events.push_back(e);
+}
+
+CollisionRules World::buildRules() { // the pairs that do something when they touch, every other pair is skipped
+    CollisionRules r;
+    for (int a = 0; a < KIND_COUNT; a++) {
+        for (int b = 0; b < KIND_COUNT; b++)
+            r.handler[a][b] = 0;
+        r.mask[a] = 0;
+    }
+    r.handler[KIND_ASTEROID][KIND_BULLET] = &World::asteroidHitByBullet;
+    r.handler[KIND_PLAYER][KIND_ASTEROID] = &World::playerHitAsteroid;
+    r.handler[KIND_PLAYER][KIND_UFO] = &World::playerHitUfo;
+    r.handler[KIND_UFO][KIND_BULLET] = &World::ufoHitByBullet;
+
+    r.layers = 0;
+    for (int a = 0; a < KIND_COUNT; a++)
+        for (int b = 0; b < KIND_COUNT; b++)
+            if (r.handler[a][b]) {
+                r.mask[a] |= kindBit(b);
+                r.layers |= kindBit(b);
+            }
+    return r;
+}
+
+const CollisionRules &World::rules() {
+    static const CollisionRules r = buildRules(); // built once, even with BatchEnv stepping games on many threads
+    return r;
+}
+
+// the handlers only read the world and write commands, see applyCommands()
+void World::asteroidHitByBullet(Ref a, Ref b) {
+    EntityArray &A = store.kinds[a.kind];
+    commands.destroy(a);
+    commands.destroy(b);
+    float x = A.x[a.index], y = A.y[a.index], R = A.R[a.index];
+
+    commands.effect(ANIM_EXPLOSION, x, y, R == 15 ? 4 : 8); // and debris
+
+    commands.event(EV_ASTEROID_HIT, x, y);
+    commands.score(33); // 33 points added to score for shooting an asteroid
+    commands.event(EV_SCORE, x, y);
+
+    for (int i = 0; i < 2; i++) {
+        if (R == 15) continue;
+        float angle = rng.next() % 360;
+        float dx = rng.next() % 8 - 4; // change in position
+        float dy = rng.next() % 8 - 4;
+        commands.spawn(KIND_ASTEROID, x, y, angle, 15, ANIM_ROCK_SMALL, dx, dy);
+    }
+}
+
+void World::playerHitAsteroid(Ref a, Ref b) { // asteroid/player collision
+    if (commands.respawning(a)) return; // already crashed this tick, it is on its way back to the middle
+    EntityArray &A = store.kinds[a.kind];
+    commands.destroy(b);
+
+    commands.effect(ANIM_EXPLOSION_SHIP, A.x[a.index], A.y[a.index], 0); // adds new explosion to be displayed
+
+    playerHit(a, 15); // 15 points lost for hitting asteroid
+}
+
+void World::playerHitUfo(Ref a, Ref b) { // ufo/player collision
+    if (commands.respawning(a)) return;
+    EntityArray &A = store.kinds[a.kind], &B = store.kinds[b.kind];
+    commands.destroy(b);
+
+    commands.effect(ANIM_EXPLOSION_SHIP, A.x[a.index], A.y[a.index], 0); // adds new explosion to be displayed
+
+    commands.event(EV_UFO_HIT, B.x[b.index], B.y[b.index]);
+    playerHit(a, 20); // 20 points lost for hitting ufo
+}
+
+void World::ufoHitByBullet(Ref a, Ref b) { // ufo/bullet collision
+    EntityArray &A = store.kinds[a.kind];
+    commands.destroy(a); // scheduled to be deleted
+    commands.destroy(b);
+
+    commands.effect(ANIM_EXPLOSION, A.x[a.index], A.y[a.index], 0); // adds explosion to be displayed
+
+    commands.score(75); // 75 points for shooting a ufo
+    commands.event(EV_SCORE, A.x[a.index], A.y[a.index]);
+
+    commands.event(EV_UFO_HIT, A.x[a.index], A.y[a.index]);
+}
+
+void World::applyCommands() {
+    PROFILE_SCOPE("apply commands");
+    size_t spawns[KIND_COUNT] = {0};
+    for (auto &c:commands.queue)
+        if (c.type == CMD_SPAWN) spawns[c.kind]++;
+    for (int k = 0; k < KIND_COUNT; k++)
+        if (spawns[k]) store.makeRoom(k, spawns[k]); // a pool grows once for the whole batch, not once per spawn
+
+    for (int t = 0; t < CMD_COUNT; t++)
+        commands.counts[t] = 0;
+    for (auto &c:commands.queue) {
+        commands.counts[c.type]++;
+        switch (c.type) {
+            case CMD_SPAWN: {
+                add(c.kind, c.x, c.y, c.angle, c.R, c.clip);
+                EntityArray &e = store.kinds[c.kind];
+                e.dx.back() = c.dx;
+                e.dy.back() = c.dy;
+                break;
+            }
+            case CMD_DESTROY:
+                store.kinds[c.ref.kind].life[c.ref.index] = 0;
+                break;
+            case CMD_SCORE:
+                if (c.value >= 0 || score >= (unsigned) -c.value) score += c.value;
+                else score = 0;
+                break;
+            case CMD_EVENT:
+                event(c.value, c.x, c.y);
+                break;
+            case CMD_EFFECT:
+                effects.explosion(c.x, c.y, c.clip);
+                if (c.value) effects.debris(c.x, c.y, c.value);
+                break;
+            case CMD_RESPAWN:
+                respawn(c.ref);
+                break;
+            case CMD_LIVES:
+                lives += c.value;
+                break;
+        }
+    }
+    for (int t = 0; t < CMD_COUNT; t++)
+        commands.totals[t] += commands.counts[t];
+    commands.queue.clear();
+}
+
+void World::step(const Input &in) {
+    PROFILE_SCOPE("step");
+    events.clear();
+    EntityArray &pl = store.kinds[KIND_PLAYER];
+#if ASTEROIDS_FIXED
+    for (size_t i = 0; i < pl.size(); i++) { // back into one turn so the quarter degrees stay exact in a float
+        if (pl.angle[i] >= 360) pl.angle[i] -= 360;
+        if (pl.angle[i] < 0) pl.angle[i] += 360;
+    }
+#endif
+    for (int k = 0; k < KIND_COUNT; k++) // for the renderer to blend the turn from
+        store.kinds[k].keepAngle();
+
+    int pi = store.find(p).index;
+
+    if (in.fire) {
+        Handle h = add(KIND_BULLET, pl.x[pi], pl.y[pi], pl.angle[pi], 10, ANIM_BULLET);
+        EntityArray &b = store.kinds[KIND_BULLET];
+        int i = store.find(h).index;
+#if ASTEROIDS_FIXED
+        b.dx[i] = fromFix((int64_t) fixCos(b.angle[i]) * 6 * FIX_ONE / 65536);
+        b.dy[i] = fromFix((int64_t) fixSin(b.angle[i]) * 6 * FIX_ONE / 65536);
+#else
+        b.dx[i] = cos(b.angle[i] * DEGTORAD) * 6; //change in position
+        b.dy[i] = sin(b.angle[i] * DEGTORAD) * 6;
+#endif
+    }
+
+    if (in.right) pl.angle[pi] += 3 * dt; // sets game control keys
+    if (in.left) pl.angle[pi] -= 3 * dt;
+    thrust = in.thrust;
+
+
+    const CollisionRules &r = rules();
+    slack = continuous ? fastest(r.layers) : 0;
+    {
+        PROFILE_SCOPE("grid build");
+        if (scrolling()) {
+            grid.place(sectors.left, sectors.top, width, height);
+            grid.build(store, r.layers, sectors.spanX, sectors.spanY);
+        } else {
+            grid.build(store, r.layers, W, H);
+        }
+    }
+
+    // explosions display -- goes through all entities on screen to check and see if any/which collisions are happening.
+    // the searching is split into chunks that can run on any thread, each chunk writes the pairs it finds into
+    // its own list. The hits are then played out here one at a time in chunk order, so the score, the random
+    // calls and the spawns happen in the same order however many threads there are. Each pair is tested again
+    // right before its handler runs because an earlier hit may have moved things (the player is put back in
+    // the middle when it crashes). The handlers don't change the arrays themselves, they write commands, and
+    // applyCommands() carries them out once every kind has been through (see commands.h)
+    for (int k = 0; k < KIND_COUNT; k++) {
+        PROFILE_SCOPE("collide");
+        unsigned mask = r.mask[k]; // the kinds this one can hit, a rock only ever looks at bullets
+        if (!mask) continue; // bullets never go looking for hits
+
+        size_t n = store.kinds[k].size(), chunks = JobPool::chunks(n, CHUNK);
+        while (hits.size() < chunks) { // room for a busy tick's hits up front, not a few at a time as they come
+            hits.emplace_back();
+            hits.back().reserve(64);
+        }
+
+        forChunks(n, [this, k, mask](size_t c, size_t begin, size_t end) { // small enough for std::function to not allocate
+            PROFILE_SCOPE("collide chunk");
+            std::vector<Hit> &out = hits[c];
+            out.clear();
+            const EntityArray &A = store.kinds[k];
+            for (size_t i = begin; i < end; i++) {
+                Ref a = {k, (int) i};
+                if (!continuous) {
+                    grid.query(a, A.x[i], A.y[i], A.R[i], mask, [this, a, &out](Ref b) { // only against the ones close enough to touch
+                        const EntityArray &A = store.kinds[a.kind], &B = store.kinds[b.kind];
+                        float sx = 0, sy = 0; // a scrolling arena's grid wraps, so b can be across the seam
+                        if (scrolling()) {
+                            sx = shift(A.x[a.index], B.x[b.index], width);
+                            sy = shift(A.y[a.index], B.y[b.index], height);
+                        }
+                        if (isCollide(A, a.index, B, b.index, sx, sy)) {
+                            Hit h = {a, b, sx, sy};
+                            out.push_back(h);
+                        }
+                    });
+                    continue;
+                }
+
+                // swept: reach as far as a moved plus as far as anything else did. Near an edge also look from
+                // the other side of the screen, for the pairs that meet across the seam
+                float reach = A.R[i] + moved(A, i, width, height) + slack;
+                float sxs[3] = {0}, sys[3] = {0};
+                int nx = 1, ny = 1;
+                if (A.x[i] - reach < 0) sxs[nx++] = width;
+                if (A.x[i] + reach > width) sxs[nx++] = -width;
+                if (A.y[i] - reach < 0) sys[ny++] = height;
+                if (A.y[i] + reach > height) sys[ny++] = -height;
+
+                for (int ix = 0; ix < nx; ix++)
+                    for (int iy = 0; iy < ny; iy++) {
+                        float sx = sxs[ix], sy = sys[iy];
+                        grid.query(a, A.x[i] + sx, A.y[i] + sy, reach, mask, [this, a, sx, sy, &out](Ref b) {
+                            if (sweptCollide(store.kinds[a.kind], a.index, store.kinds[b.kind], b.index, sx, sy, width,
+                                             height)) {
+                                Hit h = {a, b, sx, sy};
+                                out.push_back(h);
+                            }
+                        });
+                    }
+            }
+        });
+
+        PROFILE_SCOPE("apply hits");
+        const HitHandler *handlers = r.handler[k];
+        for (size_t c = 0; c < chunks; c++)
+            for (auto &h:hits[c])
+                if (touching(h))
+                    (this->*handlers[h.b.kind])(h.a, h.b);
+    }
+    applyCommands(); // every kind's hits are in, nothing is walking the arrays now
+
+
+    pl.clip[pi] = thrust ? ANIM_PLAYER_GO : ANIM_PLAYER; // go animation used when up key is pressed to move forward
+    pl.frame[pi] = 0;
+
+
+    {
+        PROFILE_SCOPE("effects");
+        effects.update(dt); // one pass over the ring, this tick's explosions included
+    }
+
+    { // new level wave and the ufo
+        PROFILE_SCOPE("spawn");
+        // increasing the difficulty of each level by adding more and more asteroids each level, as many per screen
+        if (store.kinds[KIND_ASTEROID].size() == 0 && (!scrolling() || sectors.parkedCount() == 0))
+        {
+            int screens = across * down;
+            if (level != 5) {
+                level++;
+                event(EV_LEVEL_UP, 0, 0);
+            }
+            if (level == 2) spawnRocks(15 * screens);
+            if (level == 3) spawnRocks(25 * screens);
+            if (level == 4) spawnRocks(34 * screens);
+            if (level == 5) spawnRocks(45 * screens); // final level
+        }
+
+        // only one ufo is on the screen at a time, it comes in at the left edge of what the camera shows
+        if (rng.next() % (100 * hz / 60) == 25 && store.kinds[KIND_UFO].size() == 0) {
+            float dx = 2 + rng.next() % 4; // change in position
+            float x = cameraX - W / 2, y = cameraY - H / 2 + rng.next() % H;
+            if (x < 0) x += width;
+            if (y >= height) y -= height;
+            if (y < 0) y += height;
+            Handle u = add(KIND_UFO, x, y, 270, 40, ANIM_UFO);
+            EntityArray &ufos = store.kinds[KIND_UFO];
+            int i = store.find(u).index;
+            ufos.dx[i] = dx;
+            event(EV_UFO_SPAWN, ufos.x[i], ufos.y[i], u);
+        }
+    }
+
+
+    for (int k = 0; k < KIND_COUNT; k++) // where everything was before it moved, for drawing and the next sweep
+        store.kinds[k].keepPosition();
+
+    {
+        PROFILE_SCOPE("move");
+        EntityArray &ast = store.kinds[KIND_ASTEROID], &ufos = store.kinds[KIND_UFO], &bul = store.kinds[KIND_BULLET];
+        forChunks(ast.size(), [this, &ast](size_t, size_t begin, size_t end) {
+            moveAsteroids(ast, begin, end, dt, width, height);
+        });
+        forChunks(bul.size(), [this, &bul](size_t, size_t begin, size_t end) {
+            moveBullets(bul, begin, end, dt, width, height, scrolling());
+        });
+        moveUfos(ufos, 0, ufos.size(), dt, width, height, scrolling());
+        movePlayers(pl, 0, pl.size(), thrust, dt, width, height);
+    }
+    {
+        PROFILE_SCOPE("animate");
+        for (int k = 0; k < KIND_COUNT; k++) {
+            EntityArray &e = store.kinds[k];
+            forChunks(e.size(), [this, &e](size_t, size_t begin, size_t end) { animate(e, begin, end, dt); });
+        }
+    }
+    if (scrolling()) {
+        PROFILE_SCOPE("sectors");
+        parkFar();
+    }
+    {
+        PROFILE_SCOPE("compact");
+        store.compact(); // entities scheduled to be deleted are removed, the arrays stay packed
+    }
+    if (scrolling()) {
+        PROFILE_SCOPE("sectors");
+        streamNear();
+    }
+
+    tick++;
+}
+
+void World::parkFar() {
+    EntityArray &pl = store.kinds[KIND_PLAYER];
+    int pi = store.find(p).index;
+    cameraX = pl.x[pi];
+    cameraY = pl.y[pi];
+    sectors.focus(cameraX, cameraY, W, H);
+
+    unsigned long now = tick + 1; // what is in the store has been moved through this tick already
+    EntityArray &a = store.kinds[KIND_ASTEROID];
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a.life[i] || sectors.near(a.x[i], a.y[i])) continue;
+        park(a.x[i], a.y[i], a.dx[i], a.dy[i], a.angle[i], a.R[i], a.clip[i], a.frame[i], now);
+        a.life[i] = 0; // out of the store at the compact() straight after
+    }
+
+    const int gone[2] = {KIND_BULLET, KIND_UFO}; // out of range is as good as off the screen
+    for (int k:gone) {
+        EntityArray &e = store.kinds[k];
+        for (size_t i = 0; i < e.size(); i++)
+            if (!sectors.near(e.x[i], e.y[i])) e.life[i] = 0;
+    }
+}
+
+void World::streamNear() {
+    unsigned long now = tick + 1;
+    size_t coming = 0;
+    for (int s:sectors.entered)
+        coming += sectors.parked[s].size();
+    store.makeRoom(KIND_ASTEROID, coming);
+
+    for (int s:sectors.entered) { // caught up to now and into the store
+        for (auto &r:sectors.parked[s])
+            unpark(r, now);
+        sectors.parked[s].clear();
+    }
+
+    // one run of the sectors is moved this tick, each gets a turn every FAR_FRAMES and a run is read straight
+    // through in memory order. A rock that leaves its sector is handed on to the one it is in now, or goes into
+    // the store if that one is active
+    size_t n = sectors.parked.size(), turns = Sectors::FAR_FRAMES * hz / 60, turn = now % turns;
+    size_t first = n * turn / turns, last = n * (turn + 1) / turns;
+    for (size_t s = first; s < last; s++) {
+        std::vector<Parked> &from = sectors.parked[s];
+        for (size_t i = 0; i < from.size();) {
+            Parked &r = from[i];
+            catchUp(r, now);
+            int t = sectors.of(r.x, r.y);
+            if (t == (int) s) {
+                i++;
+                continue;
+            }
+            if (sectors.active[t]) unpark(r, now);
+            else sectors.parked[t].push_back(r);
+            r = from.back(); // check i again, it holds the one that used to be last
+            from.pop_back();
+        }
+    }
+}
+
+void World::unpark(Parked &r, unsigned long now) {
+    catchUp(r, now);
+    Handle h = add(KIND_ASTEROID, r.x, r.y, r.angle, r.R, r.clip);
+    EntityArray &a = store.kinds[KIND_ASTEROID];
+    int i = store.find(h).index;
+    a.dx[i] = r.dx;
+    a.dy[i] = r.dy;
+    a.frame[i] = r.frame;
+}
+
+void World::forChunks(size_t n, const JobPool::Job &job) {
+    if (jobs) {
+        jobs->parallelFor(n, CHUNK, job);
+        return;
+    }
+    for (size_t c = 0, begin = 0; begin < n; c++, begin += CHUNK)
+        job(c, begin, std::min(n, begin + CHUNK));
+}
+
+bool World::touching(const Hit &h) const {
+    const EntityArray &A = store.kinds[h.a.kind], &B = store.kinds[h.b.kind];
+    if (continuous) return sweptCollide(A, h.a.index, B, h.b.index, h.sx, h.sy, width, height);
+    return isCollide(A, h.a.index, B, h.b.index, h.sx, h.sy);
+}
+
+float World::fastest(unsigned kinds) const {
+    float most = 0;
+    for (int k = 0; k < KIND_COUNT; k++) {
+        if (!(kinds & kindBit(k))) continue;
+        const EntityArray &e = store.kinds[k];
+        for (size_t i = 0; i < e.size(); i++)
+            most = std::max(most, moved(e, i, width, height));
+    }
+    return most;
+}
+
+namespace {
+
+const uint32_t SAVE_VERSION = 3; // bump whenever anything saved changes
+
+struct SaveHeader {
+    char magic[4]; // "ASAV"
+    uint32_t version;
+    uint64_t bytes; // the whole block, header included
+    int32_t hz;
+    uint32_t score, level;
+    int32_t lives;
+    uint64_t tick, rng;
+    uint32_t playerSlot, playerGeneration;
+    uint8_t thrust, continuous, across, down, pad[4];
+    uint64_t sectorBytes; // parked rocks after the store, 0 when the arena doesn't scroll
+};
+
+}
+
+void World::save(std::vector<uint8_t> &out) const {
+    PROFILE_SCOPE("save");
+    SaveHeader h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, "ASAV", 4);
+    h.version = SAVE_VERSION;
+    h.sectorBytes = scrolling() ? sectors.saveBytes() : 0;
+    h.bytes = sizeof h + store.saveBytes() + h.sectorBytes;
+    h.hz = hz;
+    h.score = score;
+    h.level = level;
+    h.lives = lives;
+    h.tick = tick;
+    h.rng = rng.state;
+    h.playerSlot = p.slot;
+    h.playerGeneration = p.generation;
+    h.thrust = thrust;
+    h.continuous = continuous;
+    h.across = across;
+    h.down = down;
+
+    out.resize(h.bytes);
+    memcpy(out.data(), &h, sizeof h);
+    uint8_t *end = store.save(out.data() + sizeof h);
+    if (scrolling()) sectors.save(end);
+}
+
+bool World::restore(const uint8_t *data, size_t n) {
+    PROFILE_SCOPE("restore");
+    SaveHeader h;
+    if (n < sizeof h) return false;
+    memcpy(&h, data, sizeof h);
+    if (memcmp(h.magic, "ASAV", 4) != 0 || h.version != SAVE_VERSION || h.bytes != n || h.hz != hz ||
+        h.across != across || h.down != down || h.sectorBytes > n - sizeof h)
+        return false;
+    size_t storeBytes = n - sizeof h - h.sectorBytes;
+    if (!store.restore(data + sizeof h, storeBytes)) return false;
+    Handle player(h.playerSlot, h.playerGeneration);
+    if (!store.alive(player) || store.find(player).kind != KIND_PLAYER ||
+        (scrolling() && !sectors.restore(data + sizeof h + storeBytes, h.sectorBytes))) {
+        store.clear();
+        return false;
+    }
+
+    score = h.score;
+    level = h.level;
+    lives = h.lives;
+    tick = h.tick;
+    rng.state = h.rng;
+    p = player;
+    thrust = h.thrust;
+    continuous = h.continuous;
+    events.clear();
+    effects.clear();
+    commands.clear();
+
+    cameraX = W / 2;
+    cameraY = H / 2;
+    if (scrolling()) { // back on the ship, where the step before the save left it
+        Ref r = store.find(p);
+        cameraX = store.kinds[KIND_PLAYER].x[r.index];
+        cameraY = store.kinds[KIND_PLAYER].y[r.index];
+        sectors.focus(cameraX, cameraY, W, H);
+    }
+    return true;
+}
+
+uint64_t World::hash() const { // FNV-1a over everything that decides how the game plays out from here
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void *data, size_t bytes) {
+        const unsigned char *p = (const unsigned char *) data;
+        for (size_t i = 0; i < bytes; i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+
+    mix(&score, sizeof(score));
+    mix(&level, sizeof(level));
+    mix(&lives, sizeof(lives));
+    mix(&tick, sizeof(tick));
+    mix(&rng.state, sizeof(rng.state));
+    for (int k = 0; k < KIND_COUNT; k++) {
+        const EntityArray &e = store.kinds[k];
+        size_t n = e.size();
+        mix(&n, sizeof(n));
+        if (!n) continue;
+        mix(e.x.data(), n * sizeof(float));
+        mix(e.y.data(), n * sizeof(float));
+        mix(e.dx.data(), n * sizeof(float));
+        mix(e.dy.data(), n * sizeof(float));
+        mix(e.angle.data(), n * sizeof(float));
+        mix(e.frame.data(), n * sizeof(float));
+        mix(e.clip.data(), n);
+    }
+    for (size_t s = 0; s < sectors.parked.size(); s++) { // only a scrolling arena has any
+        const std::vector<Parked> &e = sectors.parked[s];
+        size_t n = e.size();
+        if (!n) continue;
+        mix(&s, sizeof(s));
+        mix(&n, sizeof(n));
+        mix(e.data(), n * sizeof(Parked));
+    }
+    return h;
+}
@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////
+// ULTIMATE ASTEROIDS - SIMULATION
+// DESCRIPTION: Everything the game needs to play a frame without a window, sound card or GPU: the entities,
+// the collision pass, scoring and level progression. main.cpp draws it and plays the sounds, Asteroids_sim
+// runs it headless.
+// The arena is one screen in the classic game. It can also be a number of screens across and down, wrapping
+// at its edges like the screen does, with the camera following the ship and only the part of it around the
+// camera fully simulated (see sectors.h).
+///////////////////////////////////////////////////
+
+#ifndef ASTEROIDS_WORLD_H
+#define ASTEROIDS_WORLD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "commands.h"
+#include "effects.h"
+#include "entities.h"
+#include "grid.h"
+#include "jobs.h"
+#include "rng.h"
+#include "sectors.h"
+
+const int W = 1200; // height and width of app, and of the arena in the classic game
+const int H = 800;
+
+constexpr float DEGTORAD = 0.017453f; // conversion to radians
+
+// what each kind of entity does every tick, over entities [begin, end) of the array so big arrays can be split
+// between threads. dt is the length of a tick in 60 Hz frames: every speed in the game was tuned for one
+// update per frame at 60 fps, so at 120 Hz everything moves half as far per tick. w x h is the arena. Bullets
+// and the ufo go when they fly off its edge, unless wrapAround (an arena that scrolls), where they wrap like
+// everything else and the world takes them away once they are out of range of the camera
+void moveAsteroids(EntityArray &a, size_t begin, size_t end, float dt, float w, float h);
+void moveUfos(EntityArray &u, size_t begin, size_t end, float dt, float w, float h, bool wrapAround);
+void moveBullets(EntityArray &b, size_t begin, size_t end, float dt, float w, float h, bool wrapAround);
+void movePlayers(EntityArray &p, size_t begin, size_t end, bool thrust, float dt, float w, float h);
+void animate(EntityArray &e, size_t begin, size_t end, float dt);
+
+// a is shifted by (sx, sy) first, which is how a pair on opposite sides of the wraparound seam gets tested
+bool isCollide(const EntityArray &A, int a, const EntityArray &B, int b, float sx = 0, float sy = 0);
+
+// swept version: did a and b touch at any point while moving from px,py to x,y in a w x h arena?
+bool sweptCollide(const EntityArray &A, int a, const EntityArray &B, int b, float sx, float sy, float w, float h);
+
+
+struct Input { // what the human is doing this frame
+    bool left, right, thrust, fire;
+
+    Input() : left(false), right(false), thrust(false), fire(false) {}
+};
+
+// the scripted pilot the runners and benches fly: spins, fires every few frames and gives bursts of thrust, the
+// same every run. The periods are in 60 Hz frames, turned into ticks at hz
+Input pilot(unsigned long tick, int hz = 60);
+
+// 30, 60, 120 or 240, the tick rates the game is tuned for. World has to be given one of them, the fixed point
+// ship drag is only worked out for these, so anything read from outside (a replay, the command line) is checked
+bool supportedHz(int hz);
+
+enum SimEvent { // things that happened during a step that the front end wants to hear about (sounds, life icons)
+    EV_ASTEROID_HIT,
+    EV_UFO_HIT,
+    EV_UFO_SPAWN,
+    EV_PLAYER_HIT,
+    EV_SCORE, // score changed
+    EV_LEVEL_UP
+};
+
+struct WorldEvent {
+    int type; // SimEvent
+    float x, y; // where it happened, for panning the sound
+    Handle entity; // what it happened to when that entity lives on (the ufo that just arrived), otherwise none
+};
+
+class World;
+typedef void (World::*HitHandler)(Ref a, Ref b); // what happens when entity a runs into entity b
+
+struct CollisionRules { // which kinds of entity hit which, filled in once from the handlers in world.cpp
+    HitHandler handler[KIND_COUNT][KIND_COUNT]; // 0 when the pair just passes through each other
+    unsigned mask[KIND_COUNT]; // bit b set when kind a has a handler against kind b, 0 = a never looks for hits
+    unsigned layers; // every kind that can be hit by something, the only kinds put in the grid
+};
+
+class World {
+public:
+    EntityStore store;
+    Effects effects; // explosions and debris, only for looking at
+    CommandBuffer commands; // what the collision handlers asked for, applied after the collision pass
+    Handle p; // the player
+    bool thrust; // whether or not forward key is pressed -- trust = speeding up/down effect
+
+    unsigned int score;
+    unsigned int level;
+    int lives;
+    unsigned long tick; // number of steps taken so far
+    const int hz; // ticks per second of game time, one supportedHz()
+    const float dt; // one tick in 60 Hz frames
+    const int across, down; // size of the arena in screens, 1 x 1 is the classic game
+    const int width, height; // and in pixels
+    float cameraX, cameraY; // middle of what the screen shows, on the ship when the arena scrolls
+    Sectors sectors; // which parts of a scrolling arena are around the camera, and the rocks in the rest
+    Rng rng; // every random thing in this game comes from here
+
+    std::vector<WorldEvent> events; // from the last step, cleared at the start of every step
+
+    JobPool *jobs; // threads to split the step across, 0 = do everything on the calling thread
+    bool continuous; // swept collision, nothing tunnels through anything however low hz goes
+
+    explicit World(unsigned int seed, int hz = 60, int across = 1, int down = 1);
+
+    // starts a new game from seed, the same as World(seed, hz) but keeping the pools and lists already grown
+    void reset(unsigned int seed);
+
+    void step(const Input &in); // plays one tick of the game, 1/hz seconds
+
+    void spawnRocks(int n); // big rocks at random places, what every level starts with
+
+    bool scrolling() const { return across > 1 || down > 1; }
+
+    uint64_t hash() const; // fingerprint of the game state, equal hashes = the two games are in the same state
+
+    // the whole game state as one flat block: a SaveHeader (score, level, lives, tick, random state, the
+    // player's handle) then the entity store, then a scrolling arena's parked rocks. out is resized to fit and keeps its capacity, so saving into the
+    // same buffer again doesn't allocate and neither does restoring into pools that are big enough. The block is
+    // for this build on this machine (native byte order, float layout). Effects aren't saved, a restore clears them
+    void save(std::vector<uint8_t> &out) const;
+    // false for a block from another version, hz or arena size, which changes nothing, or for a damaged one, which leaves
+    // no entities and needs a reset()
+    bool restore(const uint8_t *data, size_t n);
+
+private:
+    Grid grid; // broadphase for the collision pass
+
+    struct Hit {
+        Ref a, b;
+        float sx, sy; // image of a it was found with, across the seam
+    };
+    std::vector<std::vector<Hit> > hits; // pairs found touching, one list per chunk of the collision search
+    float slack; // swept collision: furthest anything in the grid moved last tick, queries reach that much further
+
+    void forChunks(size_t n, const JobPool::Job &job);
+    bool touching(const Hit &h) const;
+    float fastest(unsigned kinds) const; // furthest anything of these kinds moved last tick
+
+    Handle add(int kind, float x, float y, float angle, float radius, int clip);
+    Handle addAsteroid(float x, float y, float angle, float radius, int clip);
+    // puts a rock in the sector x, y is in, as it is at tick now
+    void park(float x, float y, float dx, float dy, float angle, float radius, int clip, float frame,
+              unsigned long now);
+    void catchUp(Parked &r, unsigned long now) const; // moves a parked rock on by every tick since it was last moved
+    void unpark(Parked &r, unsigned long now); // caught up and into the store
+    void parkFar(); // after the move: camera onto the ship, rocks out of range parked, bullets and the ufo gone
+    void streamNear(); // after the compact: rocks of sectors come into range into the store, then far sectors move
+    void playerHit(Ref a, unsigned int penalty); // a = the ship, queues the penalty, the lost life and the respawn
+    void respawn(Ref r); // the ship back in the middle, applyCommands() does it
+    void event(int type, float x, float y, Handle entity = Handle());
+
+    static const CollisionRules &rules();
+    static CollisionRules buildRules();
+    void asteroidHitByBullet(Ref a, Ref b);
+    void playerHitAsteroid(Ref a, Ref b);
+    void playerHitUfo(Ref a, Ref b);
+    void ufoHitByBullet(Ref a, Ref b);
+    void applyCommands(); // the sync point, plays the command buffer out onto the world
+};
+
+#endif